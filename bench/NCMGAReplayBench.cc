@@ -0,0 +1,386 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGAReplayBench.cc
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+/**
+ * Replay of recorded keys, to measure how fast the widgets respond.
+ *
+ *     ymga-ncurses-replay <key file> [<output file> [<table rows>]]
+ *
+ * A dialog with a menu bar, an NCMenu and a YMGA_NCCBTable is opened and
+ * the keys of the file are fed to it one step at a time through the
+ * ncurses input queue. Each step is handled by the dialog, whichever
+ * widget gets it, then the screen is updated: the time from queueing the
+ * keys to the end of doupdate() is recorded, as well as the bytes the
+ * terminal output grew meanwhile. The terminal output goes to the output
+ * file (default "replay.out") for that; set TERM, LINES and COLUMNS for
+ * the terminal to emulate and do not type meanwhile. Then the whole
+ * screen is painted again and the time of that frame is recorded too.
+ * After the last step the 50th, 95th and 99th percentiles are written to
+ * stderr and to the yui log.
+ *
+ * The key file holds key names separated by white space, '#' starts a
+ * comment: Up, Down, Left, Right, PgUp, PgDn, Home, End, Return, Space,
+ * Tab, Esc, Backspace, F1..F12, Ctrl-<c>, Alt-<c> or a single character.
+ * Tab moves the focus between the menu and the table; sample.keys is
+ * an example.
+ **/
+
+#define  YUILogComponent "mga-ncurses"
+#include <yui/YUILog.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cwctype>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include <yui/YUI.h>
+#include <yui/YDialog.h>
+#include <yui/YLayoutBox.h>
+#include <yui/YWidgetFactory.h>
+#include <yui/mga/YMGAMenuItem.h>
+#include <yui/ncurses/NCurses.h>
+#include <yui/ncurses/NCstring.h>
+
+#include "NCMenu.h"
+#include "YMGA_NCCBTable.h"
+#include "YMGANCMenuBar.h"
+
+
+// keys of one replay step, queued together (e.g. Esc and 'x' for Alt-x)
+typedef std::vector<wint_t> ReplayStep;
+
+
+static bool parseKey( const std::string & name, ReplayStep & step )
+{
+  static const struct { const char * name; wint_t key; } named[] =
+  {
+    { "Up",        KEY_UP        },
+    { "Down",      KEY_DOWN      },
+    { "Left",      KEY_LEFT      },
+    { "Right",     KEY_RIGHT     },
+    { "PgUp",      KEY_PPAGE     },
+    { "PgDn",      KEY_NPAGE     },
+    { "Home",      KEY_HOME      },
+    { "End",       KEY_END       },
+    { "Return",    KEY_RETURN    },
+    { "Space",     KEY_SPACE     },
+    { "Tab",       KEY_TAB       },
+    { "Esc",       KEY_ESC       },
+    { "Backspace", KEY_BACKSPACE },
+  };
+
+  for ( const auto & n : named )
+  {
+    if ( name == n.name )
+    {
+      step.push_back( n.key );
+      return true;
+    }
+  }
+
+  if ( name.size() > 1 && name[0] == 'F' && isdigit( name[1] ) )
+  {
+    int n = atoi( name.c_str() + 1 );
+    if ( n >= 1 && n <= 12 )
+    {
+      step.push_back( KEY_F( n ) );
+      return true;
+    }
+  }
+
+  if ( name.compare( 0, 5, "Ctrl-" ) == 0 )
+  {
+    std::wstring ch = NCstring( name.substr( 5 ) ).str();
+    if ( ch.size() != 1 )
+      return false;
+
+    step.push_back( towlower( ch[0] ) & 0x1f );
+    return true;
+  }
+
+  if ( name.compare( 0, 4, "Alt-" ) == 0 )
+  {
+    std::wstring ch = NCstring( name.substr( 4 ) ).str();
+    if ( ch.size() != 1 )
+      return false;
+
+    step.push_back( KEY_ESC );
+    step.push_back( ch[0] );
+    return true;
+  }
+
+  std::wstring ch = NCstring( name ).str();
+  if ( ch.size() == 1 )
+  {
+    step.push_back( ch[0] );
+    return true;
+  }
+
+  return false;
+}
+
+
+/**
+ * Read the steps of key file 'fileName' into 'steps'.
+ **/
+static bool readSteps( const char * fileName, std::vector<ReplayStep> & steps )
+{
+  std::ifstream file( fileName );
+
+  if ( !file )
+  {
+    std::cerr << "Cannot read key file " << fileName << std::endl;
+    return false;
+  }
+
+  std::string line;
+  while ( std::getline( file, line ) )
+  {
+    line = line.substr( 0, line.find( '#' ) );
+
+    size_t pos = 0;
+    while ( ( pos = line.find_first_not_of( " \t\r", pos ) ) != std::string::npos )
+    {
+      size_t end = line.find_first_of( " \t\r", pos );
+      std::string name = line.substr( pos, end == std::string::npos ? end : end - pos );
+      pos = end;
+
+      ReplayStep step;
+      if ( parseKey( name, step ) )
+        steps.push_back( step );
+      else
+        std::cerr << "Unknown key " << name << std::endl;
+    }
+  }
+
+  return !steps.empty();
+}
+
+
+/**
+ * Bytes written to the terminal output so far. Both the stdio buffer and
+ * the one of ncurses are flushed by then, so the file offset is exact.
+ **/
+static long long outputOffset()
+{
+  fflush( stdout );
+
+  return lseek( STDOUT_FILENO, 0, SEEK_CUR );
+}
+
+
+/**
+ * Queue the keys of 'step' for the dialog.
+ **/
+static void queueStep( const ReplayStep & step )
+{
+  // the input queue is a stack
+  for ( ReplayStep::const_reverse_iterator it = step.rbegin(); it != step.rend(); ++it )
+  {
+    if ( *it >= KEY_MIN )
+      ::ungetch( *it );
+    else
+      ::unget_wch( *it );
+  }
+}
+
+
+/**
+ * Value below which 'percent' percent of 'values' are.
+ **/
+static long long percentile( std::vector<long long> values, unsigned percent )
+{
+  if ( values.empty() )
+    return 0;
+
+  size_t n = ( values.size() - 1 ) * percent / 100;
+  std::nth_element( values.begin(), values.begin() + n, values.end() );
+
+  return values[ n ];
+}
+
+
+static void report( const char * what, const std::vector<long long> & values )
+{
+  long long total = 0;
+  for ( long long value : values )
+    total += value;
+
+  std::cerr << what << ":"
+            << " p50 " << percentile( values, 50 )
+            << " p95 " << percentile( values, 95 )
+            << " p99 " << percentile( values, 99 )
+            << " total " << total
+            << std::endl;
+
+  yuiMilestone() << what << ":"
+                 << " p50 " << percentile( values, 50 )
+                 << " p95 " << percentile( values, 95 )
+                 << " p99 " << percentile( values, 99 )
+                 << " total " << total
+                 << std::endl;
+}
+
+
+/**
+ * Fill the menu bar with a few menus and submenus.
+ **/
+static void addMenus( YMGANCMenuBar * bar )
+{
+  static const char * menus[] = { "&File", "&Edit", "&View", "&Tools", "&Help" };
+
+  for ( const char * label : menus )
+  {
+    YMGAMenuItem * menu = new YMGAMenuItem( label );
+
+    for ( int i = 1; i <= 12; ++i )
+    {
+      YMGAMenuItem * entry = new YMGAMenuItem( menu, std::string( "Entry &" ) + std::to_string( i ) );
+
+      if ( i % 4 == 0 )
+      {
+        for ( int j = 1; j <= 8; ++j )
+          new YMGAMenuItem( entry, "Subentry " + std::to_string( j ) );
+      }
+    }
+
+    bar->addItem( menu );
+  }
+}
+
+
+int main( int argc, char ** argv )
+{
+  if ( argc < 2 )
+  {
+    std::cerr << "Usage: " << argv[0] << " <key file> [<output file> [<table rows>]]" << std::endl;
+    return 2;
+  }
+
+  const char * outputName = argc > 2 ? argv[2] : "replay.out";
+  const int    rows       = argc > 3 ? atoi( argv[3] ) : 1000;
+
+  std::vector<ReplayStep> steps;
+  if ( !readSteps( argv[1], steps ) )
+    return 1;
+
+  // the terminal output goes to a regular file, its size is what the
+  // terminal would have received
+  int output = open( outputName, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+  if ( output < 0 || dup2( output, STDOUT_FILENO ) < 0 )
+  {
+    std::cerr << "Cannot write " << outputName << std::endl;
+    return 1;
+  }
+  close( output );
+
+  YWidgetFactory * factory = YUI::widgetFactory();
+  YDialog *        dialog  = factory->createMainDialog();
+  YLayoutBox *     vbox    = factory->createVBox( dialog );
+
+  // blocking popups would run their own event loop on the next key
+  YMGANCMenuBar * bar = new YMGANCMenuBar( vbox );
+  bar->setAsyncPopups( true );
+  addMenus( bar );
+
+  YLayoutBox * hbox = factory->createHBox( vbox );
+
+  NCMenu * menu = new NCMenu( hbox );
+  for ( int i = 1; i <= 40; ++i )
+    menu->addItem( new YMGAMenuItem( "Item " + std::to_string( i ) ) );
+
+  YCBTableHeader * header = new YCBTableHeader();
+  header->addColumn( "", true );
+  header->addColumn( "Name" );
+  header->addColumn( "Size" );
+  header->addColumn( "Description" );
+
+  YMGA_NCCBTable * table = new YMGA_NCCBTable( hbox, header );
+  table->setAsyncPopups( true );
+  for ( int i = 0; i < rows; ++i )
+  {
+    YCBTableItem * item = new YCBTableItem();
+    item->addCell( i % 3 == 0 );
+    item->addCell( "package-" + std::to_string( i ) );
+    item->addCell( std::to_string( ( i * 7919 ) % 100000 ) + " kB" );
+    item->addCell( "Description of package " + std::to_string( i ) );
+    table->addItem( item );
+  }
+
+  dialog->open();
+  dialog->pollEvent();
+  ::update_panels();
+  ::doupdate();
+
+  std::vector<long long> latencies;   // microseconds
+  std::vector<long long> bytes;
+  std::vector<long long> paints;      // microseconds
+
+  for ( const ReplayStep & step : steps )
+  {
+    long long before = outputOffset();
+
+    queueStep( step );
+    std::chrono::steady_clock::time_point queued = std::chrono::steady_clock::now();
+
+    // handled by whichever widget has the focus or the hotkey
+    dialog->pollEvent();
+    ::update_panels();
+    ::doupdate();
+
+    latencies.push_back( std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - queued ).count() );
+    bytes.push_back( outputOffset() - before );
+
+    // a full frame, every widget painted whether it changed or not
+    std::chrono::steady_clock::time_point painted = std::chrono::steady_clock::now();
+
+    NCurses::Redraw();
+    ::update_panels();
+    ::doupdate();
+
+    paints.push_back( std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - painted ).count() );
+  }
+
+  dialog->destroy();
+  YUI::deleteUI();
+
+  std::cerr << "Replayed " << steps.size() << " keys" << std::endl;
+  report( "Latency (us)", latencies );
+  report( "Terminal bytes per key", bytes );
+  report( "Paint per frame (us)", paints );
+
+  return 0;
+}
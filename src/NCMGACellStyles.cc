@@ -0,0 +1,73 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGACellStyles.cc
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#define  YUILogComponent "mga-ncurses"
+#include <yui/YUILog.h>
+#include "NCMGACellStyles.h"
+
+
+static const NCTableLine::STATE cachedStates[] =
+{
+  NCTableLine::S_NORMAL,
+  NCTableLine::S_ACTIVE,
+  NCTableLine::S_DISABLED,
+  NCTableLine::S_HIDDEN,
+  NCTableLine::S_HEADLINE
+};
+
+
+NCMGACellStyles::NCMGACellStyles()
+  : _style( 0 )
+  , _list( 0 )
+  , _hotCol( -1 )
+{
+}
+
+
+void NCMGACellStyles::update( const NCTableStyle & style )
+{
+  // the list style of each widget state is a different member of the
+  // style set, so a state or style set change gives another address
+  const NCstyle::StList * list = &style.listStyle();
+
+  _style = &style;
+
+  if ( _list == list && _hotCol == style.HotCol() )
+    return;
+
+  for ( unsigned state = 0; state < STATES; ++state )
+  {
+    for ( unsigned role = 0; role < ROLES; ++role )
+    {
+      _bg[state][role]  = style.getBG( cachedStates[state],
+                                       (NCTableCol::STYLE) role );
+      _hot[state][role] = style.hotBG( cachedStates[state], role );
+    }
+  }
+
+  _list   = list;
+  _hotCol = style.HotCol();
+}
@@ -0,0 +1,112 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGACellStyles.h
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#ifndef NCMGACellStyles_h
+#define NCMGACellStyles_h
+
+#include <yui/ncurses/NCstyle.h>
+#include <yui/ncurses/NCTableItem.h>
+
+/**
+ * Background attributes of table cells, resolved once per list style.
+ *
+ * NCTableStyle computes a background from the line state and the cell
+ * role every time it is asked. Every widget owns one of these, its lines
+ * call update() before painting and then just index the table by line
+ * state and cell role (NCTableCol::STYLE). The table is resolved again
+ * only when the list style of the widget (i.e. its state or style set)
+ * or its hot column changes.
+ **/
+class NCMGACellStyles
+{
+public:
+
+    NCMGACellStyles();
+
+    /**
+     * Make the table match 'style'. This is only a comparison unless the
+     * list style or the hot column changed.
+     **/
+    void update( const NCTableStyle & style );
+
+    /**
+     * Same as NCTableStyle::getBG( vstate, role ).
+     **/
+    chtype bg( unsigned vstate, unsigned role ) const
+    {
+      int state = stateIndex( vstate );
+
+      if ( state < 0 || role == NCTableCol::NONE || role >= ROLES )
+        return _style->getBG( (NCTableLine::STATE) vstate,
+                             (NCTableCol::STYLE) role );
+
+      return _bg[state][role];
+    }
+
+    /**
+     * Same as NCTableStyle::hotBG( vstate, col ).
+     **/
+    chtype hotBG( unsigned vstate, unsigned col ) const
+    {
+      int state = stateIndex( vstate );
+
+      if ( state < 0 || col >= ROLES )
+        return _style->hotBG( (NCTableLine::STATE) vstate, col );
+
+      return _hot[state][col];
+    }
+
+private:
+
+    enum { STATES = 5, ROLES = NCTableCol::SEPARATOR + 1 };
+
+    /**
+     * Table row of line state 'vstate' or -1 if it is not cached.
+     **/
+    static int stateIndex( unsigned vstate )
+    {
+      switch ( vstate )
+      {
+        case NCTableLine::S_NORMAL:   return 0;
+        case NCTableLine::S_ACTIVE:   return 1;
+        case NCTableLine::S_DISABLED: return 2;
+        case NCTableLine::S_HIDDEN:   return 3;
+        case NCTableLine::S_HEADLINE: return 4;
+      }
+
+      return -1;
+    }
+
+    const NCTableStyle *    _style;
+    const NCstyle::StList * _list;     // list style the table was resolved for
+    int                     _hotCol;
+
+    chtype _bg[STATES][ROLES];
+    chtype _hot[STATES][ROLES];
+};
+
+
+#endif // NCMGACellStyles_h
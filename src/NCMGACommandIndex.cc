@@ -0,0 +1,280 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGACommandIndex.cc
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#define  YUILogComponent "mga-ncurses"
+#include <yui/YUILog.h>
+#include "NCMGACommandIndex.h"
+
+#include <algorithm>
+#include <cwctype>
+
+#include <yui/YShortcut.h>
+#include <yui/ncurses/NCtext.h>
+#include <yui/mga/YMGAMenuItem.h>
+
+
+// label without shortcut markers ("&&" is a literal marker)
+static std::wstring cleanLabel( const std::string & label )
+{
+  const wchar_t marker = YShortcut::shortcutMarker();
+  const std::wstring wlabel = NCstring( label ).str();
+  std::wstring clean;
+
+  clean.reserve( wlabel.size() );
+  for ( size_t i = 0; i < wlabel.size(); ++i )
+  {
+    if ( wlabel[i] == marker )
+    {
+      if ( i + 1 < wlabel.size() && wlabel[i+1] == marker )
+        clean += wlabel[++i];
+      continue;
+    }
+    clean += wlabel[i];
+  }
+
+  return clean;
+}
+
+
+void NCMGACommandIndex::add( Entries & entries, YItemConstIterator begin, YItemConstIterator end,
+                             const std::wstring & prefix )
+{
+  for ( YItemConstIterator it = begin; it != end; ++it )
+  {
+    if ( dynamic_cast<YMenuSeparator *>( *it ) )
+      continue;
+
+    YMGAMenuItem * mi = dynamic_cast<YMGAMenuItem *>( *it );
+    if ( mi && ( mi->hidden() || !mi->enabled() ) )
+      continue;
+
+    std::wstring path = prefix.empty() ? cleanLabel( (*it)->label() ) : prefix + L" > " + cleanLabel( (*it)->label() );
+
+    if ( (*it)->hasChildren() )
+    {
+      add( entries, (*it)->childrenBegin(), (*it)->childrenEnd(), path );
+      continue;
+    }
+
+    YMenuItem * item = dynamic_cast<YMenuItem *>( *it );
+    if ( !item )
+      continue;
+
+    Entry entry;
+    entry.item = item;
+    entry.key.resize( path.size() );
+    std::transform( path.begin(), path.end(), entry.key.begin(), towlower );
+    entry.path.swap( path );
+
+    entries.push_back( entry );
+  }
+}
+
+
+void NCMGACommandIndex::index( const YItem * menu )
+{
+  Entries & entries = _menus[menu];
+
+  _size -= entries.size();
+  entries.clear();
+
+  YItemCollection top( 1, const_cast<YItem *>( menu ) );
+  add( entries, top.begin(), top.end(), std::wstring() );
+
+  _size += entries.size();
+}
+
+
+void NCMGACommandIndex::build( YItemConstIterator begin, YItemConstIterator end )
+{
+  clear();
+
+  // top level items are the menu names, actions are below them
+  for ( YItemConstIterator it = begin; it != end; ++it )
+  {
+    _order.push_back( *it );
+    index( *it );
+  }
+
+  yuiDebug() << "Indexed " << _size << " actions" << std::endl;
+}
+
+
+void NCMGACommandIndex::update( YItem * item )
+{
+  while ( item->parent() )
+    item = item->parent();
+
+  if ( std::find( _order.begin(), _order.end(), item ) == _order.end() )
+    _order.push_back( item );
+
+  index( item );
+  reset();
+}
+
+
+void NCMGACommandIndex::remove( YItem * item )
+{
+  std::unordered_map<const YItem *, Entries>::iterator it = _menus.find( item );
+  if ( it == _menus.end() )
+    return;
+
+  _size -= it->second.size();
+  _menus.erase( it );
+  _order.erase( std::remove( _order.begin(), _order.end(), item ), _order.end() );
+  reset();
+}
+
+
+void NCMGACommandIndex::clear()
+{
+  _menus.clear();
+  _order.clear();
+  _size = 0;
+  reset();
+}
+
+
+void NCMGACommandIndex::reset()
+{
+  _query.clear();
+  _candidates.clear();
+}
+
+
+int NCMGACommandIndex::score( const std::wstring & key, const std::wstring & query )
+{
+  int result = 0;
+  size_t q = 0;
+  size_t last = std::wstring::npos;
+
+  for ( size_t i = 0; i < key.size() && q < query.size(); ++i )
+  {
+    if ( key[i] != query[q] )
+      continue;
+
+    result += 1;
+
+    // consecutive characters and word starts count more
+    if ( last != std::wstring::npos && i == last + 1 )
+      result += 4;
+    if ( i == 0 || !iswalnum( key[i-1] ) )
+      result += 6;
+
+    last = i;
+    ++q;
+  }
+
+  if ( q < query.size() )
+    return -1;
+
+  // prefer shorter paths
+  return result * 64 - (int) key.size();
+}
+
+
+// Best score first, menu order for the same score
+static bool betterMatch( const NCMGACommandIndex::Match & a, const NCMGACommandIndex::Match & b )
+{
+  return a.score != b.score ? a.score > b.score : a.order < b.order;
+}
+
+
+void NCMGACommandIndex::search( const std::wstring & query, std::vector<Match> & matches, size_t max )
+{
+  std::wstring lower( query.size(), L' ' );
+  std::transform( query.begin(), query.end(), lower.begin(), towlower );
+
+  matches.clear();
+
+  if ( lower.empty() )
+  {
+    // the first actions, nothing to score or sort
+    reset();
+
+    for ( const YItem * menu : _order )
+    {
+      for ( const Entry & entry : _menus[menu] )
+      {
+        if ( matches.size() >= max )
+          return;
+
+        matches.push_back( Match{ entry.item, &entry.path, 0, (unsigned) matches.size() } );
+      }
+    }
+
+    return;
+  }
+
+  // refine the last result if the query just got longer
+  bool refine = !_query.empty() && lower.size() >= _query.size() && lower.compare( 0, _query.size(), _query ) == 0;
+
+  std::vector<const Entry *> candidates;
+  unsigned order = 0;
+
+  if ( refine )
+  {
+    candidates.reserve( _candidates.size() );
+    for ( const Entry * entry : _candidates )
+    {
+      int s = score( entry->key, lower );
+      if ( s >= 0 )
+      {
+        candidates.push_back( entry );
+        matches.push_back( Match{ entry->item, &entry->path, s, order++ } );
+      }
+    }
+  }
+  else
+  {
+    for ( const YItem * menu : _order )
+    {
+      for ( const Entry & entry : _menus[menu] )
+      {
+        int s = score( entry.key, lower );
+        if ( s >= 0 )
+        {
+          candidates.push_back( &entry );
+          matches.push_back( Match{ entry.item, &entry.path, s, order++ } );
+        }
+      }
+    }
+  }
+
+  _query.swap( lower );
+  _candidates.swap( candidates );
+
+  // only the shown matches need to be sorted
+  if ( matches.size() > max )
+  {
+    std::partial_sort( matches.begin(), matches.begin() + max, matches.end(), betterMatch );
+    matches.resize( max );
+  }
+  else
+  {
+    std::sort( matches.begin(), matches.end(), betterMatch );
+  }
+}
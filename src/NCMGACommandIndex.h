@@ -0,0 +1,145 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGACommandIndex.h
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#ifndef NCMGACommandIndex_h
+#define NCMGACommandIndex_h
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <yui/YItem.h>
+#include <yui/YMenuItem.h>
+
+/**
+ * Search index over the actions (enabled and visible leaf entries) of a
+ * menu tree, used by the command palette.
+ *
+ * Every action is stored with its label path ("File > Open recent > ...")
+ * already normalized (no shortcut markers, lower case), so that a search
+ * only compares characters. The query is matched as a fuzzy subsequence;
+ * when it extends the previous one only the previous candidates are
+ * checked again.
+ *
+ * The actions are kept per top level menu, so that a change in a menu
+ * re-indexes that menu only (see update()).
+ **/
+class NCMGACommandIndex
+{
+public:
+
+    struct Match
+    {
+        YMenuItem * item;
+        const std::wstring * path;  // label path as shown
+        int score;
+        unsigned order;             // position in menu order
+    };
+
+    NCMGACommandIndex() : _size( 0 ) {}
+
+    /**
+     * Index the actions of the menu tree from 'begin' to 'end'. Submenus
+     * that are hidden or disabled are skipped.
+     **/
+    void build( YItemConstIterator begin, YItemConstIterator end );
+
+    /**
+     * Index the actions of the top level menu containing 'item' again,
+     * after entries of that menu have been changed, added or removed.
+     * The order of the top level menus must not have changed.
+     **/
+    void update( YItem * item );
+
+    /**
+     * Forget the actions of the top level menu 'item', before it is
+     * deleted.
+     **/
+    void remove( YItem * item );
+
+    /**
+     * Forget all the actions.
+     **/
+    void clear();
+
+    /**
+     * Number of indexed actions.
+     **/
+    size_t size() const { return _size; }
+
+    /**
+     * Fill 'matches' with the (at most) 'max' best actions matching
+     * 'query', best first and in menu order for the same score. An empty
+     * query matches the first actions in menu order.
+     **/
+    void search( const std::wstring & query, std::vector<Match> & matches, size_t max );
+
+private:
+
+    struct Entry
+    {
+        YMenuItem * item;
+        std::wstring path;
+        std::wstring key;
+    };
+
+    typedef std::vector<Entry> Entries;
+
+    /**
+     * Add the actions of the item from 'begin' to 'end' and their children
+     * to 'entries'.
+     **/
+    static void add( Entries & entries, YItemConstIterator begin, YItemConstIterator end,
+                     const std::wstring & prefix );
+
+    /**
+     * Index the actions of the top level menu 'menu'.
+     **/
+    void index( const YItem * menu );
+
+    /**
+     * Forget the last query, its candidates may be gone.
+     **/
+    void reset();
+
+    /**
+     * Score of 'query' (lower case) as a subsequence of 'key', or -1 if it
+     * does not match.
+     **/
+    static int score( const std::wstring & key, const std::wstring & query );
+
+    // actions of each top level menu, and the menus in order
+    std::unordered_map<const YItem *, Entries> _menus;
+    std::vector<const YItem *> _order;
+    size_t _size;
+
+    // last query and the entries matching it, in menu order
+    std::wstring _query;
+    std::vector<const Entry *> _candidates;
+};
+
+
+#endif // NCMGACommandIndex_h
@@ -0,0 +1,330 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGACommandPalette.cc
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#define  YUILogComponent "mga-ncurses"
+#include <yui/YUILog.h>
+#include "NCMGACommandPalette.h"
+#include "NCMGACommandIndex.h"
+
+#include <cwchar>
+#include <cwctype>
+#include <vector>
+
+#include <yui/ncurses/NCtext.h>
+#include <yui/ncurses/ncursesp.h>
+
+
+// shown actions
+#define MAX_PALETTE_LINES 10
+
+
+struct NCMGACommandPalette::Private
+{
+  Private()
+  : normal()
+  , active()
+  , index( 0 )
+  , panel( 0 )
+  , current( 0 )
+  {}
+
+  NCstyle::StWidget normal;
+  NCstyle::StWidget active;
+
+  NCMGACommandIndex * index;
+  NCursesPanel * panel;
+
+  std::wstring query;
+  std::vector<NCMGACommandIndex::Match> matches;
+  unsigned current;
+
+  void search();
+  void drawQuery();
+  void drawMatch( unsigned idx );
+  void drawMatches();
+  void flush();
+};
+
+
+void NCMGACommandPalette::Private::search()
+{
+  matches.clear();
+  current = 0;
+
+  if ( index )
+    index->search( query, matches, MAX_PALETTE_LINES );
+}
+
+
+void NCMGACommandPalette::Private::drawQuery()
+{
+  int width = panel->width() - 2;
+
+  panel->bkgdset( normal.plain );
+  panel->move( 1, 1 );
+  panel->hline( ' ', width );
+
+  // keep the end of a long query visible, counting display columns
+  // (wide characters take two)
+  std::wstring shown( L"> " + query );
+  size_t start = shown.size();
+  int    used  = 0;
+
+  while ( start > 0 )
+  {
+    int cols = ::wcwidth( shown[start - 1] );
+    if ( cols < 0 )
+      cols = 1;
+
+    if ( used + cols > width )
+      break;
+
+    used += cols;
+    --start;
+  }
+
+  shown.erase( 0, start );
+
+  panel->addwstr( 1, 1, shown.c_str() );
+}
+
+
+void NCMGACommandPalette::Private::drawMatch( unsigned idx )
+{
+  if ( idx >= MAX_PALETTE_LINES )
+    return;
+
+  int width = panel->width() - 2;
+  int line = idx + 3;
+
+  panel->bkgdset( normal.plain );
+  panel->move( line, 1 );
+  panel->hline( ' ', width );
+
+  if ( idx >= matches.size() )
+    return;
+
+  const NCstyle::StWidget & style( idx == current ? active : normal );
+
+  NClabel label( NCstring( *matches[idx].path ) );
+  panel->bkgdset( style.plain );
+  label.drawAt( *panel, style, wpos( line, 1 ), wsze( 1, width ), NC::LEFT );
+}
+
+
+void NCMGACommandPalette::Private::drawMatches()
+{
+  for ( unsigned idx = 0; idx < MAX_PALETTE_LINES; ++idx )
+    drawMatch( idx );
+}
+
+
+void NCMGACommandPalette::Private::flush()
+{
+  panel->top();
+  ::update_panels();
+  ::doupdate();
+}
+
+
+NCMGACommandPalette::NCMGACommandPalette()
+    : d( new Private )
+{
+  YUI_CHECK_NEW( d );
+}
+
+
+NCMGACommandPalette::~NCMGACommandPalette()
+{
+  if ( d->panel )
+  {
+    d->panel->hide();
+    delete d->panel;
+    ::update_panels();
+  }
+
+  delete d;
+}
+
+
+void NCMGACommandPalette::setStyle( const NCstyle::StWidget & normal,
+                                    const NCstyle::StWidget & active )
+{
+  d->normal = normal;
+  d->active = active;
+}
+
+
+void NCMGACommandPalette::open( NCMGACommandIndex * index, const wpos & at, int width )
+{
+  // border, search line, separator and actions
+  wsze size( MAX_PALETTE_LINES + 4, width );
+
+  if ( size.H > LINES )
+    size.H = LINES;
+  if ( size.W > COLS )
+    size.W = COLS;
+
+  wpos pos( at );
+  if ( pos.L + size.H > LINES )
+    pos.L = LINES - size.H;
+  if ( pos.C + size.W > COLS )
+    pos.C = COLS - size.W;
+
+  if ( d->panel && ( d->panel->height() != size.H || d->panel->width() != size.W ) )
+  {
+    d->panel->hide();
+    delete d->panel;
+    d->panel = 0;
+  }
+
+  if ( !d->panel )
+  {
+    d->panel = new NCursesPanel( size.H, size.W, pos.L, pos.C );
+    YUI_CHECK_NEW( d->panel );
+  }
+  else
+  {
+    d->panel->mvwin( pos.L, pos.C );
+  }
+
+  d->index = index;
+  d->query.clear();
+  d->search();
+
+  d->panel->show();
+  d->panel->bkgdset( d->normal.plain );
+  d->panel->erase();
+  d->panel->box();
+  d->panel->move( 2, 1 );
+  d->panel->hline( ACS_HLINE, size.W - 2 );
+
+  d->drawQuery();
+  d->drawMatches();
+  d->flush();
+}
+
+
+void NCMGACommandPalette::close()
+{
+  if ( !isOpen() )
+    return;
+
+  d->panel->hide();
+  d->index = 0;
+  d->matches.clear();
+
+  ::update_panels();
+  ::doupdate();
+}
+
+
+bool NCMGACommandPalette::isOpen() const
+{
+  return d->panel && d->index;
+}
+
+
+void NCMGACommandPalette::refresh()
+{
+  if ( !isOpen() )
+    return;
+
+  d->search();
+  d->drawMatches();
+  d->flush();
+}
+
+
+NCursesEvent NCMGACommandPalette::handleInput( wint_t key )
+{
+  NCursesEvent ret = NCursesEvent::none;
+
+  if ( !isOpen() )
+    return ret;
+
+  switch ( key )
+  {
+    case KEY_UP:
+    case KEY_DOWN:
+      {
+        unsigned old = d->current;
+
+        if ( key == KEY_UP && d->current > 0 )
+          --(d->current);
+        else if ( key == KEY_DOWN && d->current + 1 < d->matches.size() )
+          ++(d->current);
+
+        if ( old != d->current )
+        {
+          d->drawMatch( old );
+          d->drawMatch( d->current );
+          d->flush();
+        }
+      }
+      break;
+
+    case KEY_RETURN:
+      if ( d->current < d->matches.size() )
+      {
+        ret = NCursesEvent::menu;
+        ret.selection = d->matches[d->current].item;
+        close();
+      }
+      break;
+
+    case KEY_ESC:
+      close();
+      ret = NCursesEvent::cancel;
+      break;
+
+    case KEY_BACKSPACE:
+    case 0x7f:
+    case 0x08:
+      if ( !d->query.empty() )
+      {
+        d->query.erase( d->query.size() - 1 );
+        d->search();
+        d->drawQuery();
+        d->drawMatches();
+        d->flush();
+      }
+      break;
+
+    default:
+      if ( ( key < KEY_MIN || key > KEY_MAX ) && iswprint( key ) )
+      {
+        d->query += (wchar_t) key;
+        d->search();
+        d->drawQuery();
+        d->drawMatches();
+        d->flush();
+      }
+      break;
+  }
+
+  return ret;
+}
@@ -0,0 +1,98 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGACommandPalette.h
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#ifndef NCMGACommandPalette_h
+#define NCMGACommandPalette_h
+
+#include <yui/ncurses/NCurses.h>
+#include <yui/ncurses/NCstyle.h>
+
+class NCMGACommandIndex;
+
+/**
+ * Command palette: a panel with a search line and the best matching
+ * actions of a NCMGACommandIndex below it, re-ranked at every key.
+ *
+ * Like NCMGAMenuCascade it is not a dialog, the owner widget passes it
+ * the keys while it is open.
+ **/
+class NCMGACommandPalette
+{
+private:
+
+    NCMGACommandPalette & operator=( const NCMGACommandPalette & );
+    NCMGACommandPalette( const NCMGACommandPalette & );
+
+    struct Private;
+    Private *d;
+
+public:
+
+    NCMGACommandPalette();
+    virtual ~NCMGACommandPalette();
+
+    /**
+     * Set the styles used to paint: 'normal' for the panel and the plain
+     * entries, 'active' for the highlighted one.
+     **/
+    void setStyle( const NCstyle::StWidget & normal,
+                   const NCstyle::StWidget & active );
+
+    /**
+     * Open the palette searching 'index' with its upper left corner at
+     * screen position 'at' and 'width' columns wide.
+     **/
+    void open( NCMGACommandIndex * index, const wpos & at, int width );
+
+    /**
+     * Hide the palette.
+     **/
+    void close();
+
+    /**
+     * Return 'true' if the palette is shown.
+     **/
+    bool isOpen() const;
+
+    /**
+     * Search again after the index has been rebuilt.
+     **/
+    void refresh();
+
+    /**
+     * Handle a key: printable characters edit the search text, KEY_UP and
+     * KEY_DOWN move the highlight.
+     *
+     * Returns NCursesEvent::menu with 'selection' set when an action has
+     * been chosen (the palette is closed then), NCursesEvent::cancel when
+     * the palette has been closed by KEY_ESC and NCursesEvent::none
+     * otherwise.
+     **/
+    NCursesEvent handleInput( wint_t key );
+};
+
+
+#endif // NCMGACommandPalette_h
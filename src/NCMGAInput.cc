@@ -0,0 +1,114 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGAInput.cc
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#define  YUILogComponent "mga-ncurses"
+#include <yui/YUILog.h>
+#include "NCMGAInput.h"
+#include "NCMGALog.h"
+
+#include <yui/ncurses/NCurses.h>
+#include <yui/ncurses/ncursesp.h>
+
+
+bool NCMGAInput::idle( int timeout )
+{
+  // show what has been done for the last key first
+  ::update_panels();
+  ::doupdate();
+
+  // the dialog's own input delay is kept
+  int delay = ::wgetdelay( ::stdscr );
+
+  wint_t key;
+  ::timeout( timeout );
+  int ret = ::get_wch( &key );
+  ::timeout( delay );
+
+  if ( ret == ERR )
+    return true;
+
+  if ( ret == KEY_CODE_YES )
+    ::ungetch( key );
+  else
+    ::unget_wch( key );
+
+  return false;
+}
+
+
+unsigned NCMGAInput::drain( wint_t key )
+{
+  unsigned count = 0;
+  int delay = ::wgetdelay( ::stdscr );
+
+  ::timeout( 0 );
+
+  for ( ;; )
+  {
+    wint_t next;
+    int ret = ::get_wch( &next );
+
+    if ( ret == ERR )
+      break;
+
+    if ( ret == KEY_CODE_YES && next == key )
+    {
+      ++count;
+      continue;
+    }
+
+    if ( ret == KEY_CODE_YES )
+      ::ungetch( next );
+    else
+      ::unget_wch( next );
+
+    break;
+  }
+
+  ::timeout( delay );
+
+  if ( count )
+  {
+    mgaDebug() << "Drained " << count << " repeated keys" << std::endl;
+  }
+
+  return count;
+}
+
+
+bool NCMGAInput::isNavigationKey( wint_t key )
+{
+  switch ( key )
+  {
+    case KEY_UP:
+    case KEY_DOWN:
+    case KEY_PPAGE:
+    case KEY_NPAGE:
+      return true;
+  }
+
+  return false;
+}
@@ -0,0 +1,69 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGAInput.h
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#ifndef NCMGAInput_h
+#define NCMGAInput_h
+
+#include <cwchar>
+
+/**
+ * Helpers to look at the terminal input without waiting for the dialog,
+ * so that a widget can use the time the user spends between two keys or
+ * handle a burst of keys at once.
+ **/
+class NCMGAInput
+{
+public:
+
+    /**
+     * Update the screen and wait up to 'timeout' milliseconds for a key.
+     * Returns 'true' if no key has been pressed meanwhile; a pressed key
+     * is left in the input queue for the dialog. The input delay set by
+     * the dialog is restored.
+     **/
+    static bool idle( int timeout );
+
+    /**
+     * Take the function keys equal to 'key' that are already waiting in
+     * the input queue, e.g. from key repeat or a paste, without waiting
+     * for more. The first different key is left in the queue. Returns the
+     * number of keys taken.
+     **/
+    static unsigned drain( wint_t key );
+
+    /**
+     * Return 'true' if 'key' only moves the cursor, so that a burst of
+     * it can be handled in one go (see drain()).
+     **/
+    static bool isNavigationKey( wint_t key );
+
+private:
+
+    NCMGAInput();
+};
+
+
+#endif // NCMGAInput_h
@@ -0,0 +1,33 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGALog.cc
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#define  YUILogComponent "mga-ncurses"
+#include "NCMGALog.h"
+
+#include <cstdlib>
+
+
+bool NCMGALog::_trace = getenv( "YMGA_NCURSES_LOG_TRACE" ) != 0;
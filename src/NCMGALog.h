@@ -0,0 +1,93 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGALog.h
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#ifndef NCMGALog_h
+#define NCMGALog_h
+
+#include <yui/YUILog.h>
+
+/**
+ * Log macros for the hot paths of this plugin.
+ *
+ * Unlike yuiDebug(), a message that is not logged does not evaluate the
+ * expressions streamed into it:
+ *
+ *     mgaDebug() << "current: " << item->label() << std::endl;
+ *
+ * Levels below NCMGA_LOG_MIN_LEVEL are removed at compile time; by
+ * default all of them are compiled in. mgaDebug() costs a check of
+ * YUILog::debugLoggingEnabled(). mgaTrace() is meant for per-item and
+ * per-paint diagnostics and logs in its own component,
+ * "mga-ncurses-trace": it also needs debug logging, and the environment
+ * variable YMGA_NCURSES_LOG_TRACE set when the application starts.
+ *
+ * The macros expand to an if/else statement, so the else of an enclosing
+ * if cannot bind to them; still, brace them in an if to keep
+ * -Wdangling-else quiet.
+ **/
+
+#define NCMGA_LOG_TRACE         0
+#define NCMGA_LOG_DEBUG         1
+#define NCMGA_LOG_MILESTONE     2
+
+#ifndef NCMGA_LOG_MIN_LEVEL
+#define NCMGA_LOG_MIN_LEVEL     NCMGA_LOG_TRACE
+#endif
+
+#define mgaTrace()                                                      \
+    if ( NCMGA_LOG_MIN_LEVEL > NCMGA_LOG_TRACE                         \
+         || !NCMGALog::traceEnabled()                                   \
+         || !YUILog::debugLoggingEnabled() )                            \
+        ;                                                               \
+    else                                                                \
+        YUILog::debug( "mga-ncurses-trace", __FILE__, __LINE__, __FUNCTION__ )
+
+#define mgaDebug()                                                      \
+    if ( NCMGA_LOG_MIN_LEVEL > NCMGA_LOG_DEBUG || !YUILog::debugLoggingEnabled() ) \
+        ;                                                               \
+    else                                                                \
+        yuiDebug()
+
+
+class NCMGALog
+{
+public:
+
+    /**
+     * Return 'true' if YMGA_NCURSES_LOG_TRACE asks for mgaTrace()
+     * messages (they also need debug logging).
+     **/
+    static bool traceEnabled() { return _trace; }
+
+private:
+
+    NCMGALog();
+
+    static bool _trace;
+};
+
+
+#endif // NCMGALog_h
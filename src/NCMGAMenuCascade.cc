@@ -0,0 +1,767 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGAMenuCascade.cc
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#define  YUILogComponent "mga-ncurses"
+#include <yui/YUILog.h>
+#include "NCMGAMenuCascade.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <yui/YMenuItem.h>
+#include <yui/mga/YMGAMenuItem.h>
+#include <yui/ncurses/ncursesp.h>
+
+#include "NCMGAMenuShortcuts.h"
+#include "NCMGAInput.h"
+#include "NCMGAStats.h"
+#include "NCMGALog.h"
+
+
+// let's assume to have a menu enable scrolling for more than 10 lines
+#define MAX_LEVEL_LINES   10
+// let's assume to have a menu enable scrolling for more than 40 columns
+#define MAX_LEVEL_COLUMNS 40
+
+// entries and levels are only known to this file
+namespace
+{
+
+struct MenuEntry
+{
+  YItem * item;
+  NClabel label;
+  bool separator;
+  bool enabled;
+  bool submenu;
+};
+
+struct MenuLevel
+{
+  YItem * key;
+  std::vector<MenuEntry> entries;
+  NCursesPanel * panel;
+  wpos at;
+  wsze size;
+  int rows;     // visible entries (panel height without border)
+  int current;  // highlighted entry or -1
+  int first;    // first visible entry
+  bool drawn;   // panel shows current and first
+  YItemConstIterator begin;
+  YItemConstIterator end;
+
+  const NCMGAShortcutLevel * shortcuts;
+  NCMGAShortcutLevel own;         // if the owner does not resolve them
+  std::map<YItem *, int> byItem;  // entry index by item
+};
+
+} // namespace
+
+
+struct NCMGAMenuCascade::Private
+{
+  Private()
+  : normal()
+  , active()
+  , disabled()
+  , stats( 0 )
+  {}
+
+  NCstyle::StWidget normal;
+  NCstyle::StWidget active;
+  NCstyle::StWidget disabled;
+
+  NCMGASubmenuLoader loader;
+
+  // counters of the owning widget, if any
+  NCMGAStats * stats;
+
+  // levels that have been built so far, by key
+  std::map<YItem *, MenuLevel *> cache;
+  // shown levels, the last one is the topmost
+  std::vector<MenuLevel *> levels;
+
+  MenuLevel * buildLevel( YItem * key, YItemConstIterator begin, YItemConstIterator end );
+  void placeLevel( MenuLevel * level, const wpos & at );
+  void deleteLevel( MenuLevel * level );
+
+  void drawLevel( MenuLevel * level );
+  void drawEntry( MenuLevel * level, int idx );
+  void flush();
+
+  bool selectable( const MenuLevel * level, int idx ) const;
+  int  nextSelectable( const MenuLevel * level, int from, int step ) const;
+  void moveTo( MenuLevel * level, int idx );
+};
+
+
+MenuLevel * NCMGAMenuCascade::Private::buildLevel( YItem * key, YItemConstIterator begin, YItemConstIterator end )
+{
+  MenuLevel * level = new MenuLevel;
+  YUI_CHECK_NEW( level );
+
+  level->key     = key;
+  level->begin   = begin;
+  level->end     = end;
+  level->panel   = 0;
+  level->rows    = 0;
+  level->current = -1;
+  level->first   = 0;
+  level->drawn   = false;
+
+  // shortcuts resolved by the owner, or here once for levels it does not
+  // know (e.g. anonymous ones)
+  level->shortcuts = key && loader.shortcuts ? loader.shortcuts( key ) : 0;
+  if ( !level->shortcuts )
+  {
+    level->own.resolve( begin, end );
+    level->shortcuts = &level->own;
+  }
+
+  unsigned maxlen = 0;
+  for ( YItemConstIterator it = begin; it != end; ++it )
+  {
+    MenuEntry entry;
+    entry.item      = *it;
+    entry.separator = dynamic_cast<YMenuSeparator *>( *it ) != 0;
+    entry.enabled   = !entry.separator;
+    entry.submenu   = false;
+
+    YMGAMenuItem * mi = dynamic_cast<YMGAMenuItem *>( *it );
+    if ( mi && mi->hidden() )
+      continue;
+
+    if ( !entry.separator )
+    {
+      if ( mi )
+        entry.enabled = mi->enabled();
+
+      entry.submenu = (*it)->hasChildren() || ( loader.lazy && loader.lazy( *it ) );
+      std::string label = level->shortcuts->label( *it );
+      entry.label = NClabel( NCstring( entry.submenu ? label + " ..." : label ) );
+      entry.label.stripHotkey();
+
+      if ( maxlen < entry.label.width() )
+        maxlen = entry.label.width();
+    }
+
+    level->byItem[*it] = level->entries.size();
+    level->entries.push_back( entry );
+  }
+
+  int h = level->entries.size() > MAX_LEVEL_LINES ? MAX_LEVEL_LINES : level->entries.size();
+  int w = maxlen > MAX_LEVEL_COLUMNS ? MAX_LEVEL_COLUMNS : maxlen;
+
+  // border
+  level->size = wsze( ( h > 0 ? h : 1 ) + 2, w + 2 );
+
+  mgaDebug() << "New menu level: " << level->entries.size() << " entries, size " << level->size << std::endl;
+
+  return level;
+}
+
+
+void NCMGAMenuCascade::Private::placeLevel( MenuLevel * level, const wpos & at )
+{
+  wsze size( level->size );
+
+  if ( size.H > LINES )
+    size.H = LINES;
+
+  if ( size.W > COLS )
+    size.W = COLS;
+
+  wpos pos( at );
+
+  if ( pos.L + size.H > LINES )
+    pos.L = LINES - size.H;
+
+  if ( pos.C + size.W > COLS )
+    pos.C = COLS - size.W;
+
+  if ( pos.L < 0 )
+    pos.L = 0;
+
+  if ( pos.C < 0 )
+    pos.C = 0;
+
+  if ( level->panel && ( level->panel->height() != size.H || level->panel->width() != size.W ) )
+  {
+    delete level->panel;
+    level->panel = 0;
+  }
+
+  if ( !level->panel )
+  {
+    level->panel = new NCursesPanel( size.H, size.W, pos.L, pos.C );
+    YUI_CHECK_NEW( level->panel );
+    level->drawn = false;
+  }
+  else if ( pos != level->at )
+  {
+    level->panel->mvwin( pos.L, pos.C );
+  }
+
+  level->at   = pos;
+  level->rows = size.H - 2;
+}
+
+
+void NCMGAMenuCascade::Private::deleteLevel( MenuLevel * level )
+{
+  if ( level->panel )
+  {
+    level->panel->hide();
+    delete level->panel;
+  }
+
+  delete level;
+}
+
+
+void NCMGAMenuCascade::Private::drawLevel( MenuLevel * level )
+{
+  NCursesPanel * p = level->panel;
+
+  p->bkgdset( normal.plain );
+  p->erase();
+  p->box();
+
+  for ( int i = level->first; i < level->first + level->rows && i < (int) level->entries.size(); ++i )
+    drawEntry( level, i );
+
+  level->drawn = true;
+}
+
+
+void NCMGAMenuCascade::Private::drawEntry( MenuLevel * level, int idx )
+{
+  if ( idx < level->first || idx >= level->first + level->rows || idx >= (int) level->entries.size() )
+    return;
+
+  NCursesPanel * p = level->panel;
+  const MenuEntry & entry = level->entries[idx];
+  int line = idx - level->first + 1;
+  int width = p->width() - 2;
+
+  if ( entry.separator )
+  {
+    p->bkgdset( normal.plain );
+    p->move( line, 1 );
+    p->hline( ACS_HLINE, width );
+    return;
+  }
+
+  const NCstyle::StWidget & style( !entry.enabled ? disabled : ( idx == level->current ? active : normal ) );
+
+  p->bkgdset( style.plain );
+  entry.label.drawAt( *p, style, wpos( line, 1 ), wsze( 1, width ), NC::LEFT );
+}
+
+
+void NCMGAMenuCascade::Private::flush()
+{
+  // keep the stacking order even if the owner dialog has been raised
+  for ( MenuLevel * level : levels )
+    level->panel->top();
+
+  ::update_panels();
+  ::doupdate();
+}
+
+
+bool NCMGAMenuCascade::Private::selectable( const MenuLevel * level, int idx ) const
+{
+  return idx >= 0 && idx < (int) level->entries.size() && level->entries[idx].enabled;
+}
+
+
+int NCMGAMenuCascade::Private::nextSelectable( const MenuLevel * level, int from, int step ) const
+{
+  for ( int i = from; i >= 0 && i < (int) level->entries.size(); i += step )
+  {
+    if ( selectable( level, i ) )
+      return i;
+  }
+
+  return -1;
+}
+
+
+void NCMGAMenuCascade::Private::moveTo( MenuLevel * level, int idx )
+{
+  if ( idx < 0 || idx == level->current )
+    return;
+
+  int old = level->current;
+  level->current = idx;
+
+  if ( idx < level->first )
+  {
+    level->first = idx;
+    drawLevel( level );
+  }
+  else if ( idx >= level->first + level->rows )
+  {
+    level->first = idx - level->rows + 1;
+    drawLevel( level );
+  }
+  else
+  {
+    drawEntry( level, old );
+    drawEntry( level, idx );
+  }
+
+  flush();
+}
+
+
+NCMGAMenuCascade::NCMGAMenuCascade()
+    : d( new Private )
+{
+  YUI_CHECK_NEW( d );
+}
+
+
+NCMGAMenuCascade::~NCMGAMenuCascade()
+{
+  d->levels.clear();
+
+  for ( auto & cached : d->cache )
+    d->deleteLevel( cached.second );
+  d->cache.clear();
+
+  ::update_panels();
+
+  delete d;
+}
+
+
+void NCMGAMenuCascade::setStyle( const NCstyle::StWidget & normal,
+                                 const NCstyle::StWidget & active,
+                                 const NCstyle::StWidget & disabled )
+{
+  d->normal   = normal;
+  d->active   = active;
+  d->disabled = disabled;
+}
+
+
+void NCMGAMenuCascade::setSubmenuLoader( const NCMGASubmenuLoader & loader )
+{
+  d->loader = loader;
+}
+
+
+void NCMGAMenuCascade::setStats( NCMGAStats * stats )
+{
+  d->stats = stats;
+}
+
+
+void NCMGAMenuCascade::open( YItem * key,
+                             YItemConstIterator begin,
+                             YItemConstIterator end,
+                             const wpos & at )
+{
+  MenuLevel * level = 0;
+
+  std::map<YItem *, MenuLevel *>::iterator cached = d->cache.find( key );
+  if ( cached != d->cache.end() )
+  {
+    if ( key )
+    {
+      level = cached->second;
+    }
+    else
+    {
+      // anonymous levels are never reused
+      d->deleteLevel( cached->second );
+      d->cache.erase( cached );
+    }
+  }
+
+  if ( !level )
+  {
+    level = d->buildLevel( key, begin, end );
+    d->cache[key] = level;
+  }
+
+  d->placeLevel( level, at );
+
+  int current = d->nextSelectable( level, 0, 1 );
+  int first   = current >= level->rows ? current - level->rows + 1 : 0;
+
+  // a prefetched level is already painted
+  if ( !level->drawn || level->current != current || level->first != first )
+  {
+    level->current = current;
+    level->first   = first;
+    d->drawLevel( level );
+  }
+
+  level->panel->show();
+  d->levels.push_back( level );
+
+  d->flush();
+}
+
+
+void NCMGAMenuCascade::prefetch( YItem * key,
+                                 YItemConstIterator begin,
+                                 YItemConstIterator end,
+                                 const wpos & at,
+                                 int idle )
+{
+  // anonymous levels are never reused
+  if ( !key || d->cache.find( key ) != d->cache.end() )
+    return;
+
+  if ( idle >= 0 && !NCMGAInput::idle( idle ) )
+    return;
+
+  MenuLevel * level = d->buildLevel( key, begin, end );
+  d->cache[key] = level;
+
+  d->placeLevel( level, at );
+  level->panel->hide();
+
+  level->current = d->nextSelectable( level, 0, 1 );
+  if ( level->current >= level->rows )
+    level->first = level->current - level->rows + 1;
+  d->drawLevel( level );
+
+  mgaDebug() << "Prefetched " << key->label() << std::endl;
+}
+
+
+void NCMGAMenuCascade::prefetchSubmenu( int idle )
+{
+  if ( d->levels.empty() )
+    return;
+
+  MenuLevel * level = d->levels.back();
+  if ( !d->selectable( level, level->current ) || !level->entries[level->current].submenu )
+    return;
+
+  YItem * item = level->entries[level->current].item;
+  if ( !item->hasChildren() )
+    return;
+
+  wpos at( level->at + wpos( level->current - level->first, level->panel->width() - 1 ) );
+  prefetch( item, item->childrenBegin(), item->childrenEnd(), at, idle );
+}
+
+
+bool NCMGAMenuCascade::openSubmenu()
+{
+  if ( d->levels.empty() )
+    return false;
+
+  MenuLevel * level = d->levels.back();
+  if ( !d->selectable( level, level->current ) || !level->entries[level->current].submenu )
+    return false;
+
+  YItem * item = level->entries[level->current].item;
+
+  if ( d->loader.lazy && d->loader.load && d->loader.lazy( item ) )
+    d->loader.load( item );
+
+  if ( !item->hasChildren() )
+    return false;
+
+  wpos at( level->at + wpos( level->current - level->first, level->panel->width() - 1 ) );
+
+  mgaDebug() << "Submenu " << item->label() << " position: " << at << std::endl;
+
+  open( item, item->childrenBegin(), item->childrenEnd(), at );
+
+  return true;
+}
+
+
+void NCMGAMenuCascade::closeLevel()
+{
+  if ( d->levels.empty() )
+    return;
+
+  d->levels.back()->panel->hide();
+  d->levels.pop_back();
+
+  d->flush();
+}
+
+
+void NCMGAMenuCascade::close()
+{
+  if ( d->levels.empty() )
+    return;
+
+  while ( !d->levels.empty() )
+  {
+    d->levels.back()->panel->hide();
+    d->levels.pop_back();
+  }
+
+  d->flush();
+}
+
+
+bool NCMGAMenuCascade::isOpen() const
+{
+  return !d->levels.empty();
+}
+
+
+unsigned NCMGAMenuCascade::depth() const
+{
+  return d->levels.size();
+}
+
+
+YItem * NCMGAMenuCascade::currentItem() const
+{
+  if ( d->levels.empty() )
+    return 0;
+
+  MenuLevel * level = d->levels.back();
+
+  return d->selectable( level, level->current ) ? level->entries[level->current].item : 0;
+}
+
+
+bool NCMGAMenuCascade::hasHotkey( wint_t key ) const
+{
+  if ( d->levels.empty() )
+    return false;
+
+  const MenuLevel * level = d->levels.back();
+
+  if ( d->stats )
+    d->stats->add( NCMGAStats::HotkeyLookups );
+
+  std::map<YItem *, int>::const_iterator it = level->byItem.find( level->shortcuts->find( key ) );
+
+  return it != level->byItem.end() && level->entries[it->second].enabled;
+}
+
+
+NCursesEvent NCMGAMenuCascade::handleInput( wint_t key )
+{
+  NCursesEvent ret = NCursesEvent::none;
+
+  if ( d->levels.empty() )
+    return ret;
+
+  MenuLevel * level = d->levels.back();
+  int idx = -1;
+
+  switch ( key )
+  {
+    case KEY_UP:
+      d->moveTo( level, d->nextSelectable( level, level->current - 1, -1 ) );
+      break;
+
+    case KEY_DOWN:
+      d->moveTo( level, d->nextSelectable( level, level->current + 1, 1 ) );
+      break;
+
+    case KEY_HOME:
+      d->moveTo( level, d->nextSelectable( level, 0, 1 ) );
+      break;
+
+    case KEY_END:
+      d->moveTo( level, d->nextSelectable( level, level->entries.size() - 1, -1 ) );
+      break;
+
+    case KEY_PPAGE:
+      idx = level->current - level->rows;
+      d->moveTo( level, d->nextSelectable( level, idx < 0 ? 0 : idx, idx < 0 ? 1 : -1 ) );
+      break;
+
+    case KEY_NPAGE:
+      idx = level->current + level->rows;
+      if ( idx >= (int) level->entries.size() )
+        d->moveTo( level, d->nextSelectable( level, level->entries.size() - 1, -1 ) );
+      else
+        d->moveTo( level, d->nextSelectable( level, idx, 1 ) );
+      break;
+
+    case KEY_RIGHT:
+      openSubmenu();
+      break;
+
+    case KEY_LEFT:
+      closeLevel();
+      if ( d->levels.empty() )
+      {
+        ret = NCursesEvent::cancel;
+        ret.detail = NCursesEvent::CONTINUE;
+      }
+      break;
+
+    case KEY_ESC:
+      close();
+      ret = NCursesEvent::cancel;
+      break;
+
+    default:
+      if ( key != KEY_RETURN && key != KEY_SPACE )
+      {
+        // hotkey: the function keys used here are handled above, other
+        // key codes cannot be told from characters of the same value
+        if ( d->stats )
+          d->stats->add( NCMGAStats::HotkeyLookups );
+
+        std::map<YItem *, int>::const_iterator it = level->byItem.find( level->shortcuts->find( key ) );
+
+        if ( it == level->byItem.end() || !level->entries[it->second].enabled )
+          break;
+
+        idx = it->second;
+
+        d->moveTo( level, idx );
+      }
+
+      if ( d->selectable( level, level->current ) )
+      {
+        const MenuEntry & entry = level->entries[level->current];
+
+        if ( entry.submenu )
+        {
+          openSubmenu();
+        }
+        else
+        {
+          YMenuItem * item = dynamic_cast<YMenuItem *>( entry.item );
+          close();
+
+          if ( item )
+          {
+            ret = NCursesEvent::menu;
+            ret.selection = item;
+          }
+        }
+      }
+      break;
+  }
+
+  return ret;
+}
+
+
+void NCMGAMenuCascade::invalidate( YItem * key )
+{
+  // levels cannot be dropped while they are shown
+  for ( MenuLevel * level : d->levels )
+  {
+    if ( !key || level->key == key )
+    {
+      close();
+      break;
+    }
+  }
+
+  if ( !key )
+  {
+    for ( auto & cached : d->cache )
+      d->deleteLevel( cached.second );
+    d->cache.clear();
+
+    return;
+  }
+
+  std::map<YItem *, MenuLevel *>::iterator cached = d->cache.find( key );
+  if ( cached != d->cache.end() )
+  {
+    d->deleteLevel( cached->second );
+    d->cache.erase( cached );
+  }
+}
+
+
+void NCMGAMenuCascade::refresh( YItem * key )
+{
+  // hidden levels are just rebuilt on next open
+  for ( std::map<YItem *, MenuLevel *>::iterator it = d->cache.begin(); it != d->cache.end(); )
+  {
+    if ( ( !key || it->first == key ) &&
+         std::find( d->levels.begin(), d->levels.end(), it->second ) == d->levels.end() )
+    {
+      d->deleteLevel( it->second );
+      it = d->cache.erase( it );
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  bool redrawn = false;
+
+  for ( MenuLevel * & shown : d->levels )
+  {
+    if ( key && shown->key != key )
+      continue;
+
+    MenuLevel * old = shown;
+    YItem * current = d->selectable( old, old->current ) ? old->entries[old->current].item : 0;
+
+    MenuLevel * level = old->key ?
+      d->buildLevel( old->key, old->key->childrenBegin(), old->key->childrenEnd() ) :
+      d->buildLevel( old->key, old->begin, old->end );
+
+    // reuse the panel, placeLevel() resizes it if needed
+    level->panel = old->panel;
+    level->at    = old->at;
+    old->panel   = 0;
+    d->placeLevel( level, old->at );
+    level->panel->show();
+
+    std::map<YItem *, int>::const_iterator it = level->byItem.find( current );
+    level->current = it != level->byItem.end() && d->selectable( level, it->second ) ?
+      it->second : d->nextSelectable( level, 0, 1 );
+
+    level->first = old->first;
+    if ( level->first + level->rows > (int) level->entries.size() )
+      level->first = std::max( 0, (int) level->entries.size() - level->rows );
+    if ( level->current >= 0 && level->current < level->first )
+      level->first = level->current;
+    else if ( level->current >= level->first + level->rows )
+      level->first = level->current - level->rows + 1;
+
+    d->cache[level->key] = level;
+    d->deleteLevel( old );
+    shown = level;
+
+    d->drawLevel( level );
+    redrawn = true;
+  }
+
+  if ( redrawn )
+    d->flush();
+}
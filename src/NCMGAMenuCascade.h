@@ -0,0 +1,201 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGAMenuCascade.h
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#ifndef NCMGAMenuCascade_h
+#define NCMGAMenuCascade_h
+
+#include <functional>
+
+#include <yui/YItem.h>
+#include <yui/ncurses/NCurses.h>
+#include <yui/ncurses/NCstyle.h>
+#include <yui/ncurses/NCtext.h>
+
+class NCMGAShortcutLevel;
+class NCMGAStats;
+
+/**
+ * Hooks of the owner of the menu items.
+ *
+ * For submenus whose entries are created only when they are opened:
+ * 'lazy' returns true if an item has such a submenu that has not been
+ * created yet, 'load' creates its entries as children of the item.
+ *
+ * 'shortcuts' returns the shortcuts resolved by the owner for the
+ * children of an item, or 0 if it does not keep them.
+ **/
+struct NCMGASubmenuLoader
+{
+    std::function<bool( YItem * item )> lazy;
+    std::function<void( YItem * item )> load;
+    std::function<const NCMGAShortcutLevel *( YItem * item )> shortcuts;
+};
+
+
+/**
+ * Cascading menu engine.
+ *
+ * All the open levels of one menu are managed here, every level is an
+ * ncurses panel that is built once (layout, labels and window) and then
+ * shown or hidden while the user moves between levels. Moving from one
+ * level to another costs a repaint of the changed panels only, no dialog
+ * or widget tree is created.
+ **/
+class NCMGAMenuCascade
+{
+private:
+
+    NCMGAMenuCascade & operator=( const NCMGAMenuCascade & );
+    NCMGAMenuCascade( const NCMGAMenuCascade & );
+
+    struct Private;
+    Private *d;
+
+public:
+
+    NCMGAMenuCascade();
+    virtual ~NCMGAMenuCascade();
+
+    /**
+     * Set the styles used to paint the entries: 'normal' for the plain
+     * entries, 'active' for the highlighted one and 'disabled' for
+     * disabled ones.
+     **/
+    void setStyle( const NCstyle::StWidget & normal,
+                   const NCstyle::StWidget & active,
+                   const NCstyle::StWidget & disabled );
+
+    /**
+     * Set the hooks used to open submenus that are created on demand.
+     **/
+    void setSubmenuLoader( const NCMGASubmenuLoader & loader );
+
+    /**
+     * Count the hotkey lookups in 'stats', the counters of the widget
+     * owning the cascade (0 for none).
+     **/
+    void setStats( NCMGAStats * stats );
+
+    /**
+     * Open a new level showing the items from 'begin' to 'end' with its
+     * upper left corner at screen position 'at'.
+     *
+     * 'key' identifies the level (usually the parent menu item): a level
+     * that has already been opened with the same key is shown again
+     * instead of being rebuilt.
+     **/
+    void open( YItem * key,
+               YItemConstIterator begin,
+               YItemConstIterator end,
+               const wpos & at );
+
+    /**
+     * Build the level that open() would show for the same arguments,
+     * without showing it: layout, labels and window are ready, so that
+     * opening it later is just a show operation.
+     *
+     * If 'idle' is not negative this is done only if it is not built yet
+     * and the user does not press a key for 'idle' milliseconds.
+     **/
+    void prefetch( YItem * key,
+                   YItemConstIterator begin,
+                   YItemConstIterator end,
+                   const wpos & at,
+                   int idle = -1 );
+
+    /**
+     * Prefetch the submenu of the highlighted entry of the topmost level,
+     * if it has one that does not need to be loaded. See prefetch() for
+     * 'idle'.
+     **/
+    void prefetchSubmenu( int idle = -1 );
+
+    /**
+     * Open the submenu of the highlighted entry of the topmost level.
+     * Returns false if that entry has no submenu.
+     **/
+    bool openSubmenu();
+
+    /**
+     * Hide the topmost level.
+     **/
+    void closeLevel();
+
+    /**
+     * Hide all the levels.
+     **/
+    void close();
+
+    /**
+     * Return 'true' if at least one level is shown.
+     **/
+    bool isOpen() const;
+
+    /**
+     * Number of levels currently shown.
+     **/
+    unsigned depth() const;
+
+    /**
+     * Return the highlighted item of the topmost level or 0.
+     **/
+    YItem * currentItem() const;
+
+    /**
+     * Return 'true' if an enabled entry of the topmost level has 'key'
+     * as hotkey.
+     **/
+    bool hasHotkey( wint_t key ) const;
+
+    /**
+     * Handle a key for the topmost level.
+     *
+     * Returns NCursesEvent::menu with 'selection' set when a leaf entry
+     * has been chosen (all levels are closed then), NCursesEvent::cancel
+     * when the last level has been closed (detail is
+     * NCursesEvent::CONTINUE if it was closed by KEY_LEFT) and
+     * NCursesEvent::none otherwise.
+     **/
+    NCursesEvent handleInput( wint_t key );
+
+    /**
+     * Forget the cached level identified by 'key' (it is rebuilt on next
+     * open), or all of them if 'key' is 0.
+     **/
+    void invalidate( YItem * key = 0 );
+
+    /**
+     * Rebuild the shown level identified by 'key' in place after its items
+     * have changed (labels, enabled or hidden state), or forget it if it
+     * is hidden. If 'key' is 0 this is done for all the levels. The
+     * highlighted entries are kept where possible and the screen is
+     * updated once.
+     **/
+    void refresh( YItem * key = 0 );
+};
+
+
+#endif // NCMGAMenuCascade_h
@@ -0,0 +1,180 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGAMenuShortcuts.cc
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#define  YUILogComponent "mga-ncurses"
+#include <yui/YUILog.h>
+#include "NCMGAMenuShortcuts.h"
+
+#include <vector>
+#include <cwctype>
+
+#include <yui/YShortcut.h>
+#include <yui/ncurses/NCurses.h>
+#include <yui/mga/YMGAMenuItem.h>
+
+
+bool NCMGAShortcutLevel::isShortcutKey( wint_t key, bool functionKey )
+{
+  return !functionKey && iswalnum( key );
+}
+
+
+wchar_t NCMGAShortcutLevel::findShortcut( const std::wstring & label )
+{
+  const wchar_t marker = YShortcut::shortcutMarker();
+
+  for ( size_t i = 0; i + 1 < label.size(); ++i )
+  {
+    if ( label[i] != marker )
+      continue;
+
+    // "&&" is a literal marker character
+    if ( label[i+1] == marker )
+    {
+      ++i;
+      continue;
+    }
+
+    return isShortcutKey( label[i+1] ) ? towlower( label[i+1] ) : 0;
+  }
+
+  return 0;
+}
+
+
+void NCMGAShortcutLevel::resolve( YItemConstIterator begin,
+                                  YItemConstIterator end )
+{
+  const wchar_t marker = YShortcut::shortcutMarker();
+  std::vector<YItem *> conflicts;
+
+  clear();
+
+  for ( YItemConstIterator it = begin; it != end; ++it )
+  {
+    if ( dynamic_cast<YMenuSeparator *>( *it ) )
+      continue;
+
+    YMGAMenuItem * mi = dynamic_cast<YMGAMenuItem *>( *it );
+    if ( mi && mi->hidden() )
+      continue;
+
+    wchar_t shortcut = findShortcut( NCstring( (*it)->label() ).str() );
+
+    if ( shortcut == 0 || _hotkeys.count( shortcut ) )
+      conflicts.push_back( *it );
+    else
+      set( shortcut, *it );
+  }
+
+  for ( YItem * item : conflicts )
+  {
+    const std::wstring label = NCstring( item->label() ).str();
+
+    // drop the old marker, keep escaped ones
+    std::wstring clean;
+    clean.reserve( label.size() + 1 );
+    for ( size_t i = 0; i < label.size(); ++i )
+    {
+      if ( label[i] == marker )
+      {
+        if ( i + 1 < label.size() && label[i+1] == marker )
+          clean += label[i++];
+        else
+          continue;
+      }
+      clean += label[i];
+    }
+
+    size_t index = 0;
+    for ( ; index < clean.size(); ++index )
+    {
+      if ( clean[index] == marker )
+      {
+        ++index;
+        continue;
+      }
+
+      wchar_t ch = towlower( clean[index] );
+      if ( isShortcutKey( ch ) && !_hotkeys.count( ch ) )
+      {
+        set( ch, item );
+        break;
+      }
+    }
+
+    if ( index < clean.size() )
+      clean.insert( index, 1, marker );
+    else
+      yuiMilestone() << "No free shortcut for " << item->label() << std::endl;
+
+    std::string shown = NCstring( clean ).Str();
+    if ( shown != item->label() )
+      _labels[item] = shown;
+  }
+}
+
+
+void NCMGAShortcutLevel::set( wchar_t key, YItem * item )
+{
+  _hotkeys[key] = item;
+  _keys[item]   = key;
+}
+
+
+wchar_t NCMGAShortcutLevel::key( const YItem * item ) const
+{
+  std::unordered_map<const YItem *, wchar_t>::const_iterator it = _keys.find( item );
+
+  return it != _keys.end() ? it->second : 0;
+}
+
+
+std::string NCMGAShortcutLevel::label( const YItem * item ) const
+{
+  std::unordered_map<const YItem *, std::string>::const_iterator it = _labels.find( item );
+
+  return it != _labels.end() ? it->second : item->label();
+}
+
+
+void NCMGAShortcutLevel::clear()
+{
+  _hotkeys.clear();
+  _keys.clear();
+  _labels.clear();
+}
+
+
+YItem * NCMGAShortcutLevel::find( wint_t key, bool functionKey ) const
+{
+  if ( !isShortcutKey( key, functionKey ) )
+    return 0;
+
+  std::unordered_map<wint_t, YItem *>::const_iterator it = _hotkeys.find( towlower( key ) );
+
+  return it != _hotkeys.end() ? it->second : 0;
+}
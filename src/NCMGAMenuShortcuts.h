@@ -0,0 +1,120 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGAMenuShortcuts.h
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#ifndef NCMGAMenuShortcuts_h
+#define NCMGAMenuShortcuts_h
+
+#include <string>
+#include <unordered_map>
+
+#include <yui/YItem.h>
+
+/**
+ * Shortcuts (hotkeys) of one menu level.
+ *
+ * resolve() assigns a unique shortcut character to every visible entry of
+ * the level in a single pass: a shortcut marked in the label is kept if
+ * it is not used yet, entries without one or with a conflicting one get
+ * the first free letter of their label. Shortcut characters are wide
+ * characters, so non-ASCII letters work as well.
+ *
+ * The labels of the items are never changed, label() returns the label
+ * to show, with the resolved shortcut marked. The result is also a
+ * dispatch table from (lower case) key to item.
+ **/
+class NCMGAShortcutLevel
+{
+public:
+
+    NCMGAShortcutLevel() {}
+
+    /**
+     * Resolve the shortcuts of the items from 'begin' to 'end'. Separators
+     * and hidden entries get none.
+     **/
+    void resolve( YItemConstIterator begin, YItemConstIterator end );
+
+    /**
+     * Make 'key' the shortcut of 'item', to build the table of items that
+     * are shown for already resolved ones (see key()).
+     **/
+    void set( wchar_t key, YItem * item );
+
+    /**
+     * Return the item whose shortcut is 'key' or 0. See isShortcutKey()
+     * for 'functionKey'.
+     **/
+    YItem * find( wint_t key, bool functionKey = false ) const;
+
+    /**
+     * Return 'true' if 'key' is the shortcut of an item of this level.
+     **/
+    bool has( wint_t key, bool functionKey = false ) const
+        { return find( key, functionKey ) != 0; }
+
+    /**
+     * Return the shortcut of 'item' (lower case) or 0.
+     **/
+    wchar_t key( const YItem * item ) const;
+
+    /**
+     * Return the label to show for 'item': its own label with the
+     * resolved shortcut marked.
+     **/
+    std::string label( const YItem * item ) const;
+
+    /**
+     * Forget all the shortcuts.
+     **/
+    void clear();
+
+    /**
+     * Return 'true' if 'key' can be a shortcut, i.e. it is a letter or
+     * digit and not a curses function key.
+     *
+     * Function key codes overlap wide characters (KEY_MIN..KEY_MAX are
+     * also U+0101..U+01FF, e.g. 'ā' or 'ž'), so they cannot be told by
+     * value: 'functionKey' says whether get_wch() returned 'key' as
+     * KEY_CODE_YES. The keys the dialog sends to wHandleHotkey() are
+     * always characters.
+     **/
+    static bool isShortcutKey( wint_t key, bool functionKey = false );
+
+    /**
+     * Return the shortcut character marked in 'label' (lower case) or 0.
+     **/
+    static wchar_t findShortcut( const std::wstring & label );
+
+private:
+
+    std::unordered_map<wint_t, YItem *> _hotkeys;
+    std::unordered_map<const YItem *, wchar_t> _keys;
+    // labels to show where they differ from the item label
+    std::unordered_map<const YItem *, std::string> _labels;
+};
+
+
+#endif // NCMGAMenuShortcuts_h
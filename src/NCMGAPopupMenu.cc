@@ -29,21 +29,58 @@
 #include "NCMGAPopupMenu.h"
 #include "YMGAMenuItem.h"
 #include "NCMenu.h"
+#include "NCMGAMenuCascade.h"
+#include "NCMGAMenuShortcuts.h"
+#include "NCMGAStats.h"
+#include "NCMGATrace.h"
+#include "NCMGALog.h"
 #include <yui/ncurses/NCTable.h>
 
+// idle time (milliseconds) before the highlighted submenu is prefetched
+#define PREFETCH_DELAY 100
+
 struct NCMGAPopupMenu::Private
 {
+    Private()
+        : stats( "NCMGAPopupMenu" )
+    {}
+
     NCMenu *menu;
     unsigned maxlen;
     wpos pos;
     bool selected;
+    // leaf chosen in a submenu level
+    YMenuItem *chosen;
 
     //std::vector<YMGAMenuItem *> items;
     std::map<YMGAMenuItem *, YMGAMenuItem *> itemsMap;
+    // parent of the shown items
+    YItem *root;
+
+    // submenu levels are shown by the cascade, no nested popup is posted
+    NCMGAMenuCascade cascade;
+    NCMGASubmenuLoader loader;
+
+    // performance counters, see NCMGAStats
+    NCMGAStats stats;
 };
 
 
-NCMGAPopupMenu::NCMGAPopupMenu( const wpos & at, YItemIterator begin, YItemIterator end )
+// Label of the copy of 'item' shown by the menu
+static std::string menuLabel( YMGAMenuItem * item,
+                              const NCMGAShortcutLevel * sc,
+                              const NCMGASubmenuLoader & loader )
+{
+    std::string label = sc ? sc->label( item ) : item->label();
+
+    if ( item->hasChildren() || ( loader.lazy && loader.lazy( item ) ) )
+      label += " ...";
+
+    return label;
+}
+
+
+NCMGAPopupMenu::NCMGAPopupMenu( const wpos & at, YItemIterator begin, YItemIterator end, const NCMGASubmenuLoader & loader )
     : NCPopup( at )
     , d(new Private)
 {
@@ -57,11 +94,20 @@ NCMGAPopupMenu::NCMGAPopupMenu( const wpos & at, YItemIterator begin, YItemItera
     d->maxlen = 0;
     d->pos = at;
     d->selected = false;
+    d->chosen = 0;
+    d->cascade.setStyle( widgetStyle( true ), widgetStyle( false ), wStyle().disabled );
+    d->cascade.setSubmenuLoader( loader );
+    d->cascade.setStats( &d->stats );
+    d->loader = loader;
     //d->menu->setNotify(true);
 
-    yuiDebug() << "Menu position: " << at << std::endl;
+    mgaDebug() << "Menu position: " << at << std::endl;
+
+    // shortcuts of the level as resolved by the owner of the items (if any)
+    d->root = begin != end ? (*begin)->parent() : 0;
+    const NCMGAShortcutLevel *sc = loader.shortcuts && d->root ? loader.shortcuts( d->root ) : 0;
+    NCMGAShortcutLevel menuShortcuts;
 
-    defsze = wsze(1, 1);
     for ( YItemIterator it = begin; it != end; ++it )
     {
         YMenuSeparator *separator = dynamic_cast<YMenuSeparator *>( *it );
@@ -69,33 +115,38 @@ NCMGAPopupMenu::NCMGAPopupMenu( const wpos & at, YItemIterator begin, YItemItera
         {
           YMenuSeparator * sep = new YMenuSeparator(NULL);
           d->menu->addItem( sep );
-          defsze.H = defsze.H > 9 ? 10 : defsze.H + 1;
         }
         else
         {
           YMGAMenuItem * item = dynamic_cast<YMGAMenuItem *>( *it );
           YUI_CHECK_PTR( item );
 
-          std::string label = item->hasChildren() ? item->label() + " ..." : item->label();
-          YMGAMenuItem *menuItem = new YMGAMenuItem ( label, item->iconName() );
+          YMGAMenuItem *menuItem = new YMGAMenuItem ( menuLabel( item, sc, loader ), item->iconName() );
           menuItem->enable(item->enabled());
           menuItem->hide(item->hidden());
 
           d->menu->addItem( menuItem );
           d->itemsMap[menuItem] = item;
-
-          if (d->maxlen < label.length()+1)
-              d->maxlen = label.length()+1;
-          // let's assume to have a menu enable scrolling for more than 10 lines
-          int h = defsze.H > 9 ? 10 : defsze.H + 1;
-          // let's assume to have a menu enable scrolling for more than 40 columns
-          int w = d->maxlen > 40 ? 40 : d->maxlen;
-
-          defsze = wsze( h,  w );
-          yuiDebug() << "Add Item: " << item->label()  << " len: "<< label.length() << " HxW "<< h << "x" << w << std::endl;
+          if ( sc && sc->key( item ) )
+            menuShortcuts.set( sc->key( item ), menuItem );
+          mgaTrace() << "Add Item: " << item->label() << std::endl;
         }
     }
-    yuiDebug() << "defsze: " << defsze << "line length: " << d->maxlen << std::endl;
+
+    if ( sc )
+      d->menu->setShortcuts( menuShortcuts );
+
+    // sizes come from the menu layout, labels are measured once there
+    wsze content = d->menu->contentSize();
+    d->maxlen = content.W + 1;
+
+    // let's assume to have a menu enable scrolling for more than 10 lines
+    int h = content.H + 1 > 10 ? 10 : content.H + 1;
+    // let's assume to have a menu enable scrolling for more than 40 columns
+    int w = d->maxlen > 40 ? 40 : d->maxlen;
+
+    defsze = wsze( h, w );
+    mgaDebug() << "defsze: " << defsze << "line length: " << d->maxlen << std::endl;
 
     //d->menu->stripHotkeys();
 }
@@ -118,20 +169,66 @@ int NCMGAPopupMenu::preferredWidth()
 }
 
 
+void NCMGAPopupMenu::refresh( YItem * key )
+{
+    if ( key && key != d->root )
+    {
+      d->cascade.refresh( key );
+      return;
+    }
+
+    if ( !key )
+      d->cascade.refresh();
+
+    const NCMGAShortcutLevel *sc = d->loader.shortcuts && d->root ? d->loader.shortcuts( d->root ) : 0;
+    NCMGAShortcutLevel menuShortcuts;
+
+    for ( auto & copy : d->itemsMap )
+    {
+      YMGAMenuItem * item = copy.second;
+
+      copy.first->setLabel( menuLabel( item, sc, d->loader ) );
+      copy.first->enable( item->enabled() );
+      copy.first->hide( item->hidden() );
+
+      if ( sc && sc->key( item ) )
+        menuShortcuts.set( sc->key( item ), copy.first );
+    }
+
+    if ( sc )
+      d->menu->setShortcuts( menuShortcuts );
+
+    // the popup keeps its size, longer labels are cut
+    d->menu->refresh();
+}
+
+
+const NCMGAStats & NCMGAPopupMenu::stats() const
+{
+    return d->stats;
+}
+
+
 bool NCMGAPopupMenu::HasHotkey(int key)
 {
-  yuiDebug() << key << std::endl;
+  mgaTrace() << key << std::endl;
+
+  if ( d->cascade.isOpen() )
+    return d->cascade.hasHotkey(key);
 
   return d->menu->HasHotkey(key);
 }
 
 NCursesEvent NCMGAPopupMenu::wHandleHotkey( wint_t key )
 {
-    yuiDebug() << "Key: " << key << std::endl;
-    if ( key >= 0 && key < UCHAR_MAX ) //  < myPad()->setItemByKey( key ) )
+    mgaDebug() << "Key: " << key << std::endl;
+    if ( d->cascade.isOpen() )
+      return wHandleInput( key );
+
+    if ( NCMGAShortcutLevel::isShortcutKey( key ) )
     {
       NCursesEvent ev = d->menu->wHandleHotkey(key);
-      yuiDebug() << "event: " << ev << std::endl;
+      mgaDebug() << "event: " << ev << std::endl;
       if (ev != NCursesEvent::none)
         return wHandleInput( KEY_SPACE );
     }
@@ -141,30 +238,45 @@ NCursesEvent NCMGAPopupMenu::wHandleHotkey( wint_t key )
 
 NCursesEvent NCMGAPopupMenu::wHandleInput( wint_t ch )
 {
+    NCMGATraceSpan span( "NCMGAPopupMenu::wHandleInput" );
+    NCMGAStats::poll();
+
     NCursesEvent ret;
     d->selected = false;
 
-    yuiDebug() << "ch: " << int(ch)  << std::endl;
+    mgaDebug() << "ch: " << int(ch)  << std::endl;
+
+    if ( d->cascade.isOpen() )
+    {
+      NCursesEvent ev = d->cascade.handleInput( ch );
+
+      if ( ev == NCursesEvent::menu )
+      {
+        // store selection
+        d->chosen = ev.selection;
+        d->selected = true;
+        ret = NCursesEvent::button;
+      }
+      else if ( ev == NCursesEvent::cancel && ev.detail != NCursesEvent::CONTINUE )
+      {
+        ret = NCursesEvent::cancel;
+      }
+
+      return ret;
+    }
+
     switch ( ch )
     {
       case KEY_RIGHT:
-        {
-          YMGAMenuItem * selitem = dynamic_cast<YMGAMenuItem *>(d->menu->currentItem());
-          if (selitem)
-          {
-              YMGAMenuItem * item = d->itemsMap[ selitem ];
-              if (item->hasChildren() )
-              {
-                  ret = NCursesEvent::button;
-                  d->selected = true;
-              }
-          }
-        }
+          openSubmenu();
       break;
       case 0x20: //Space
       case 0x0A: //Return
-          ret = NCursesEvent::button;
-          d->selected = true;
+          if ( !openSubmenu() )
+          {
+            ret = NCursesEvent::button;
+            d->selected = true;
+          }
       break;
       case KEY_LEFT:
           ret = NCursesEvent::cancel;
@@ -180,13 +292,103 @@ NCursesEvent NCMGAPopupMenu::wHandleInput( wint_t ch )
 }
 
 
+bool NCMGAPopupMenu::openSubmenu()
+{
+    YMGAMenuItem * selected = dynamic_cast<YMGAMenuItem *>(d->menu->currentItem());
+    if ( !selected )
+      return false;
+
+    YMGAMenuItem * item = d->itemsMap[ selected ];
+
+    if ( d->loader.lazy && d->loader.load && d->loader.lazy( item ) )
+      d->loader.load( item );
+
+    if ( !item->hasChildren() )
+      return false;
+
+    // open the submenu level beside the current line, this popup keeps posting
+    wpos at( ScreenPos() + wpos( d->menu->visibleLine( selected ), inparent.Sze.W - 1 ) );
+    mgaDebug() << "Submenu " << item->label() << " position: " << at << std::endl;
+
+    d->cascade.open( item, item->childrenBegin(), item->childrenEnd(), at );
+
+    return true;
+}
+
+
+void NCMGAPopupMenu::prefetchSubmenu()
+{
+    if ( d->cascade.isOpen() )
+    {
+      d->cascade.prefetchSubmenu();
+      return;
+    }
+
+    YMGAMenuItem * selected = dynamic_cast<YMGAMenuItem *>(d->menu->currentItem());
+    if ( !selected )
+      return;
+
+    // lazy submenus are only created when they are opened
+    YMGAMenuItem * item = d->itemsMap[ selected ];
+    if ( !item->hasChildren() )
+      return;
+
+    wpos at( ScreenPos() + wpos( d->menu->visibleLine( selected ), inparent.Sze.W - 1 ) );
+    d->cascade.prefetch( item, item->childrenBegin(), item->childrenEnd(), at );
+}
+
+
+int NCMGAPopupMenu::post( NCursesEvent * returnEvent )
+{
+    postevent = NCursesEvent();
+
+    do
+    {
+        initDialog();
+        showDialog();
+        activate( true );
+
+        for ( ;; )
+        {
+            postevent = userInput( PREFETCH_DELAY );
+
+            // a timeout is not an answer, the user is idle
+            if ( postevent == NCursesEvent::timeout )
+                prefetchSubmenu();
+            else if ( postevent != NCursesEvent::none )
+                break;
+        }
+
+        activate( false );
+    }
+    while ( postAgain() );
+
+    popdownDialog();
+
+    if ( returnEvent )
+        *returnEvent = postevent;
+
+    return postevent.detail;
+}
+
+
 bool NCMGAPopupMenu::postAgain()
 {
-    // dont mess up postevent.detail here
-    bool again = false;
+    NCMGATraceSpan span( "NCMGAPopupMenu::postAgain" );
 
+    // dont mess up postevent.detail here
     if (d->selected)
     {
+      if ( d->chosen )
+      {
+          // leaf chosen in a submenu level
+          yuiMilestone() << "Menu item: " << d->chosen->label() << " " << d->chosen->index() << std::endl;
+          postevent.detail = d->chosen->index();
+          d->chosen = 0;
+
+          return false;
+      }
+
       YMGAMenuItem * selected = dynamic_cast<YMGAMenuItem *>(d->menu->currentItem());
 
       if ( !selected )
@@ -198,29 +400,10 @@ bool NCMGAPopupMenu::postAgain()
       YMGAMenuItem * item = d->itemsMap[ selected ];
       yuiMilestone() << "Menu item: " << item->label() << " " << item->index() << std::endl;
 
-      if ( item->hasChildren() )
-      {
-          // post submenu
-          wpos at( ScreenPos() + wpos( selected->index(), inparent.Sze.W - 1 ) );
-          yuiDebug() << "Submenu " << item->label() << " position: " << at << std::endl;
-
-          NCMGAPopupMenu * dialog = new NCMGAPopupMenu( at,
-                  item->childrenBegin(),
-                  item->childrenEnd() );
-          YUI_CHECK_NEW( dialog );
-
-          again = ( dialog->post( &postevent ) == NCursesEvent::CONTINUE );
-          // dialog has been closed but ask the menu father to contine eventually, so let's delete it
-          YDialog::deleteTopmostDialog();
-      }
-      else
-      {
-          // store selection
-          postevent.detail = item->index();
-          again = false;
-      }
+      // store selection
+      postevent.detail = item->index();
     }
 
-    return again;
+    return false;
 }
 
@@ -33,6 +33,8 @@
 #include <yui/ncurses/NCPopup.h>
 #include <yui/mga/YMGAMenuItem.h>
 
+#include "NCMGAMenuCascade.h"
+
 class NCMGAPopupMenu : public NCPopup
 {
 private:
@@ -54,15 +56,51 @@ protected:
     bool HasHotkey(int key);
     NCursesEvent wHandleHotkey( wint_t key );
 
+    /**
+     * Open the submenu of the current item, if any, as a new level
+     * of the cascade.
+     **/
+    bool openSubmenu();
+
+    /**
+     * Build the submenu of the highlighted entry (hidden) so that opening
+     * it is immediate. This is done when the user is idle, see post().
+     **/
+    void prefetchSubmenu();
+
 
 public:
 
+    /**
+     * Constructor, 'loader' creates the entries of submenus that are
+     * created on demand (if any).
+     **/
     NCMGAPopupMenu( const wpos & at,
                  YItemIterator begin,
-                 YItemIterator end );
+                 YItemIterator end,
+                 const NCMGASubmenuLoader & loader = NCMGASubmenuLoader() );
 
     virtual ~NCMGAPopupMenu();
 
+    /**
+     * Same as NCPopup::post(), but the input is read with a timeout: when
+     * the user does not press a key for a while the highlighted submenu
+     * is prefetched, instead of waiting for that after every key.
+     **/
+    int post( NCursesEvent * returnEvent = 0 );
+
+    /**
+     * Show the entries of the menu level identified by 'key' (the parent
+     * of its items) again after they have changed, all the levels if
+     * 'key' is 0.
+     **/
+    void refresh( YItem * key = 0 );
+
+    /**
+     * Performance counters of this popup menu.
+     **/
+    const NCMGAStats & stats() const;
+
 };
 
 
@@ -0,0 +1,202 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGAStats.cc
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#define  YUILogComponent "mga-ncurses"
+#include <yui/YUILog.h>
+#include "NCMGAStats.h"
+
+#include <cstdlib>
+#include <mutex>
+#include <set>
+#include <signal.h>
+
+
+const bool NCMGAStats::_enabled = getenv( "YMGA_NCURSES_STATS" ) != 0;
+volatile std::sig_atomic_t NCMGAStats::_dumpRequested = 0;
+
+
+// counters of the live widgets and totals of the deleted ones, only
+// used if counting is enabled
+static std::mutex                 registryMutex;
+static std::set<NCMGAStats *>     registry;
+static std::atomic<unsigned long> retired[ NCMGAStats::COUNTERS ];
+static bool                       handlersInstalled = false;
+
+
+NCMGAStats::NCMGAStats( const char * owner )
+  : _owner( owner )
+{
+  for ( unsigned i = 0; i < COUNTERS; ++i )
+    _counters[ i ] = 0;
+
+  if ( !_enabled )
+    return;
+
+  std::lock_guard<std::mutex> lock( registryMutex );
+
+  registry.insert( this );
+
+  if ( !handlersInstalled )
+  {
+    // registered after the yui log exists, so it is run before the log
+    // is destroyed
+    atexit( dumpAtExit );
+
+    // leave SIGUSR2 alone if the application handles it
+    struct sigaction action;
+    if ( sigaction( SIGUSR2, 0, &action ) == 0 && action.sa_handler == SIG_DFL )
+    {
+      action.sa_handler = requestDump;
+      action.sa_flags   = SA_RESTART;
+      sigemptyset( &action.sa_mask );
+      sigaction( SIGUSR2, &action, 0 );
+    }
+
+    handlersInstalled = true;
+  }
+}
+
+
+NCMGAStats::~NCMGAStats()
+{
+  if ( !_enabled )
+    return;
+
+  std::lock_guard<std::mutex> lock( registryMutex );
+
+  registry.erase( this );
+
+  for ( unsigned i = 0; i < COUNTERS; ++i )
+    retired[ i ] += value( (Counter) i );
+}
+
+
+unsigned long NCMGAStats::total( Counter counter )
+{
+  std::lock_guard<std::mutex> lock( registryMutex );
+
+  unsigned long sum = retired[ counter ];
+
+  for ( const NCMGAStats * stats : registry )
+    sum += stats->value( counter );
+
+  return sum;
+}
+
+
+const char * NCMGAStats::name( Counter counter )
+{
+  switch ( counter )
+  {
+    case TablePaints:           return "table paints";
+    case TableLinePaints:       return "table line paints";
+    case TableLinesBuilt:       return "table lines built";
+    case TableCellsAllocated:   return "table cells allocated";
+    case TableSorts:            return "table sorts";
+    case TableSortMicroseconds: return "table sort time (us)";
+    case MenuPaints:            return "menu paints";
+    case MenuLinesBuilt:        return "menu lines built";
+    case PopupMenus:            return "popup menus built";
+    case MenuBarPaints:         return "menu bar paints";
+    case HotkeyLookups:         return "hotkey lookups";
+    case AcceleratorLookups:    return "accelerator lookups";
+    case LabelBytes:            return "label bytes";
+    case COUNTERS:              break;
+  }
+
+  return "?";
+}
+
+
+void NCMGAStats::reset()
+{
+  for ( unsigned i = 0; i < COUNTERS; ++i )
+    _counters[ i ] = 0;
+}
+
+
+void NCMGAStats::resetAll()
+{
+  std::lock_guard<std::mutex> lock( registryMutex );
+
+  for ( NCMGAStats * stats : registry )
+    stats->reset();
+
+  for ( unsigned i = 0; i < COUNTERS; ++i )
+    retired[ i ] = 0;
+}
+
+
+void NCMGAStats::dump() const
+{
+  yuiMilestone() << "Counters of " << _owner << " " << this
+                 << ( _enabled ? "" : " (disabled)" ) << ":" << std::endl;
+
+  for ( unsigned i = 0; i < COUNTERS; ++i )
+  {
+    unsigned long n = value( (Counter) i );
+
+    if ( n )
+      yuiMilestone() << "  " << name( (Counter) i ) << ": " << n << std::endl;
+  }
+}
+
+
+void NCMGAStats::dumpAll()
+{
+  {
+    std::lock_guard<std::mutex> lock( registryMutex );
+
+    for ( const NCMGAStats * stats : registry )
+      stats->dump();
+  }
+
+  yuiMilestone() << "Widget counters total" << ( _enabled ? "" : " (disabled)" ) << ":" << std::endl;
+
+  for ( unsigned i = 0; i < COUNTERS; ++i )
+    yuiMilestone() << "  " << name( (Counter) i ) << ": " << total( (Counter) i ) << std::endl;
+}
+
+
+void NCMGAStats::dumpAtExit()
+{
+  dumpAll();
+}
+
+
+void NCMGAStats::requestDump( int )
+{
+  _dumpRequested = 1;
+}
+
+
+void NCMGAStats::dumpRequested()
+{
+  _dumpRequested = 0;
+
+  yuiMilestone() << "SIGUSR2 received" << std::endl;
+  dumpAll();
+}
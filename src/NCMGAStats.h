@@ -0,0 +1,157 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGAStats.h
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#ifndef NCMGAStats_h
+#define NCMGAStats_h
+
+#include <atomic>
+#include <csignal>
+
+/**
+ * Performance counters of one widget of this plugin.
+ *
+ * Every table, menu, popup menu and menu bar owns one of these. Counting
+ * is enabled by setting the environment variable YMGA_NCURSES_STATS
+ * before the application starts; when disabled add() is a test of a flag
+ * and nothing else. The counters of a widget are read with value(), the
+ * sum over all the widgets (deleted ones included) with total(). dump()
+ * writes the counters of one widget to the yui log, dumpAll() those of
+ * all the widgets and the totals. If counting is enabled dumpAll() is
+ * also done when the application exits, and on SIGUSR2 while it runs:
+ * the signal only sets a flag, the widgets check it with poll() when
+ * they handle the next key.
+ **/
+class NCMGAStats
+{
+public:
+
+    enum Counter
+    {
+        TablePaints,            // full table paints
+        TableLinePaints,        // paints of a single table line
+        TableLinesBuilt,
+        TableCellsAllocated,
+        TableSorts,
+        TableSortMicroseconds,
+        MenuPaints,
+        MenuLinesBuilt,
+        PopupMenus,             // popup menus constructed
+        MenuBarPaints,
+        HotkeyLookups,
+        AcceleratorLookups,
+        LabelBytes,             // bytes of the labels stored for display
+        COUNTERS
+    };
+
+    /**
+     * Create the counters of a widget, shown as 'owner' (e.g. its class
+     * name) in the log.
+     **/
+    NCMGAStats( const char * owner );
+
+    /**
+     * The counters are added to the totals of the deleted widgets.
+     **/
+    ~NCMGAStats();
+
+    /**
+     * Return 'true' if counting is enabled.
+     **/
+    static bool enabled() { return _enabled; }
+
+    /**
+     * Add 'n' to 'counter'.
+     **/
+    void add( Counter counter, unsigned long n = 1 )
+    {
+        if ( _enabled )
+            _counters[ counter ].fetch_add( n, std::memory_order_relaxed );
+    }
+
+    /**
+     * Current value of 'counter'.
+     **/
+    unsigned long value( Counter counter ) const
+        { return _counters[ counter ].load( std::memory_order_relaxed ); }
+
+    /**
+     * Sum of 'counter' over all the widgets, including the deleted ones.
+     **/
+    static unsigned long total( Counter counter );
+
+    /**
+     * Name of 'counter' as written by dump().
+     **/
+    static const char * name( Counter counter );
+
+    /**
+     * Set all the counters of this widget to 0.
+     **/
+    void reset();
+
+    /**
+     * Set the counters of all the widgets and the totals to 0.
+     **/
+    static void resetAll();
+
+    /**
+     * Write the counters of this widget to the yui log.
+     **/
+    void dump() const;
+
+    /**
+     * Write the counters of all the widgets and their totals to the yui
+     * log.
+     **/
+    static void dumpAll();
+
+    /**
+     * Do dumpAll() if SIGUSR2 was received since the last call.
+     **/
+    static void poll()
+    {
+        if ( _dumpRequested )
+            dumpRequested();
+    }
+
+private:
+
+    NCMGAStats & operator=( const NCMGAStats & );
+    NCMGAStats( const NCMGAStats & );
+
+    static void dumpAtExit();
+    static void dumpRequested();
+    static void requestDump( int );
+
+    const char *                      _owner;
+    std::atomic<unsigned long>        _counters[ COUNTERS ];
+
+    static const bool                 _enabled;
+    static volatile std::sig_atomic_t _dumpRequested;
+};
+
+
+#endif // NCMGAStats_h
@@ -0,0 +1,188 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGATrace.cc
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#define  YUILogComponent "mga-ncurses"
+#include <yui/YUILog.h>
+#include "NCMGATrace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <functional>
+#include <thread>
+#include <unistd.h>
+
+#define TRACE_RING_SIZE 65536
+
+
+// trace types are only known to this file
+namespace
+{
+
+struct TraceEvent
+{
+  const char * name;
+  int64_t      start;
+  int64_t      duration;
+};
+
+
+// spans of one thread, only touched by that thread
+struct TraceRing
+{
+  TraceRing() : next( 0 ), count( 0 ) {}
+
+  TraceEvent events[ TRACE_RING_SIZE ];
+  unsigned   next;
+  unsigned   count;
+};
+
+} // namespace
+
+
+// serializes writing to the trace file, not recording
+static std::mutex traceFileMutex;
+static bool       traceFileStarted = false;
+
+static const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+
+
+static void writeJsonString( FILE * file, const char * str )
+{
+  fputc( '"', file );
+  for ( ; *str; ++str )
+  {
+    if ( *str == '"' || *str == '\\' )
+      fputc( '\\', file );
+    fputc( *str, file );
+  }
+  fputc( '"', file );
+}
+
+
+static void flushRing( TraceRing & ring )
+{
+  if ( ring.count == 0 )
+    return;
+
+  std::lock_guard<std::mutex> lock( traceFileMutex );
+
+  const char * fileName = getenv( "YMGA_NCURSES_TRACE" );
+  FILE * file = fopen( fileName, traceFileStarted ? "a" : "w" );
+
+  if ( !file )
+  {
+    yuiError() << "Cannot write trace file " << fileName << std::endl;
+    return;
+  }
+
+  // JSON array format, the closing bracket is optional
+  if ( !traceFileStarted )
+    fputs( "[\n", file );
+
+  const long pid = getpid();
+  const unsigned long tid = std::hash<std::thread::id>()( std::this_thread::get_id() ) & 0xffffffff;
+
+  unsigned index = ( ring.next + TRACE_RING_SIZE - ring.count ) % TRACE_RING_SIZE;
+
+  for ( unsigned i = 0; i < ring.count; ++i )
+  {
+    const TraceEvent & event( ring.events[ index ] );
+
+    fputs( traceFileStarted || i > 0 ? ",\n{\"name\":" : "{\"name\":", file );
+    writeJsonString( file, event.name );
+    fprintf( file, ",\"cat\":\"mga-ncurses\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":%ld,\"tid\":%lu}",
+             (long long) event.start, (long long) event.duration, pid, tid );
+
+    index = ( index + 1 ) % TRACE_RING_SIZE;
+  }
+
+  fclose( file );
+
+  yuiMilestone() << "Wrote " << ring.count << " trace spans to " << fileName << std::endl;
+
+  traceFileStarted = true;
+  ring.count = 0;
+  ring.next  = 0;
+}
+
+
+// buffer of the calling thread, flushed when the thread ends
+static TraceRing & traceRing()
+{
+  // allocated on first use, threads that are never traced do not pay
+  // for the buffer
+  static thread_local struct Owner
+  {
+    Owner() : ring( new TraceRing ) {}
+    ~Owner() { flushRing( *ring ); delete ring; }
+
+    TraceRing * ring;
+  } owner;
+
+  return *owner.ring;
+}
+
+
+bool NCMGATrace::_enabled = NCMGATrace::init();
+
+
+bool NCMGATrace::init()
+{
+  const char * file = getenv( "YMGA_NCURSES_TRACE" );
+
+  return file && *file;
+}
+
+
+int64_t NCMGATrace::now()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+           std::chrono::steady_clock::now() - traceEpoch ).count();
+}
+
+
+void NCMGATrace::record( const char * name, int64_t start, int64_t duration )
+{
+  TraceRing & ring( traceRing() );
+
+  TraceEvent & event( ring.events[ ring.next ] );
+  event.name     = name;
+  event.start    = start;
+  event.duration = duration;
+
+  ring.next = ( ring.next + 1 ) % TRACE_RING_SIZE;
+  if ( ring.count < TRACE_RING_SIZE )
+    ++ring.count;
+}
+
+
+void NCMGATrace::flush()
+{
+  if ( _enabled )
+    flushRing( traceRing() );
+}
@@ -0,0 +1,112 @@
+/*
+  Copyright 2020 by Angelo Naselli <anaselli at linux dot it>
+
+  This library is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) version 3.0 of the License. This library
+  is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details. You should have received a copy of the GNU
+  Lesser General Public License along with this library; if not, write
+  to the Free Software Foundation, Inc., 51 Franklin Street, Fifth
+  Floor, Boston, MA 02110-1301 USA
+
+*/
+
+
+/*-/
+
+   File:       NCMGATrace.h
+
+   Author:     Angelo Naselli <anaselli@linux.it>
+
+/-*/
+
+#ifndef NCMGATrace_h
+#define NCMGATrace_h
+
+#include <cstdint>
+
+/**
+ * Optional tracing of the hot paths of the widgets.
+ *
+ * If the environment variable YMGA_NCURSES_TRACE names a file, every
+ * NCMGATraceSpan records its name, start and duration into a ring buffer
+ * of the calling thread (no locking, the oldest spans are overwritten
+ * when it is full). The buffers are written to that file in Chrome
+ * trace-event format (JSON array) when their thread ends, i.e. at exit
+ * for the UI thread, or by flush(). The file can be opened with Perfetto
+ * or chrome://tracing.
+ *
+ * With tracing disabled a span only tests a flag.
+ **/
+class NCMGATrace
+{
+public:
+
+    /**
+     * Return 'true' if spans are recorded.
+     **/
+    static bool enabled() { return _enabled; }
+
+    /**
+     * Record a span of the calling thread. Times are in microseconds.
+     **/
+    static void record( const char * name, int64_t start, int64_t duration );
+
+    /**
+     * Current time in microseconds.
+     **/
+    static int64_t now();
+
+    /**
+     * Write the spans recorded by the calling thread to the trace file
+     * and empty its buffer.
+     **/
+    static void flush();
+
+private:
+
+    NCMGATrace();
+
+    static bool init();
+
+    static bool _enabled;
+};
+
+
+/**
+ * A traced span: from construction to destruction of the object.
+ *
+ *     NCMGATraceSpan span( "YMGA_NCCBTable::DrawPad" );
+ *
+ * 'name' must be a string literal (it is stored, not copied).
+ **/
+class NCMGATraceSpan
+{
+public:
+
+    explicit NCMGATraceSpan( const char * name )
+        : _name( NCMGATrace::enabled() ? name : 0 )
+        , _start( _name ? NCMGATrace::now() : 0 )
+    {}
+
+    ~NCMGATraceSpan()
+    {
+        if ( _name )
+            NCMGATrace::record( _name, _start, NCMGATrace::now() - _start );
+    }
+
+private:
+
+    NCMGATraceSpan( const NCMGATraceSpan & );
+    NCMGATraceSpan & operator=( const NCMGATraceSpan & );
+
+    const char * _name;
+    int64_t      _start;
+};
+
+
+#endif // NCMGATrace_h
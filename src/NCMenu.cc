@@ -27,12 +27,22 @@
 #define	 YUILogComponent "ncurses"
 #include <yui/YUILog.h>
 #include "NCMenu.h"
+#include "NCMGAInput.h"
+#include "NCMGAStats.h"
+#include "NCMGATrace.h"
+#include "NCMGALog.h"
 #include <yui/ncurses/YNCursesUI.h>
 
 #include <yui/YMenuItem.h>
 #include <yui/YSelectionWidget.h>
 #include <yui/mga/YMGAMenuItem.h>
 
+#include <algorithm>
+
+// let's assume to have a menu enable scrolling for more than 10 lines,
+// only that many lines are created, see NCMenu::scrollTo()
+#define MAX_MENU_LINES 10
+
 
 class NCMenuLine : public NCTableLine
 {
@@ -40,22 +50,39 @@ class NCMenuLine : public NCTableLine
 private:
 
     YMenuItem *		yitem;
+    NClabel		label;	// shown label, hotkey stripped
 
     NCMenuLine * nsibling;
     NCMenuLine * fchild;
 
     mutable chtype * prefix;
 
+    // cell backgrounds, owned by the menu
+    NCMGACellStyles * cellStyles;
+
 
 public:
 
-    NCMenuLine( YMenuItem * item )
+    NCMenuLine( YMenuItem * item, const std::string & shown, NCMGACellStyles * styles )
         : NCTableLine( 0 )
-        , yitem( item )
+        , yitem( 0 )
         , nsibling( 0 )
         , fchild( 0 )
         , prefix( 0 )
+        , cellStyles( styles )
+    {
+        bind( item, shown );
+    }
+
+    // show 'item' on this line with label 'shown' (its shortcut resolved),
+    // lines are reused while scrolling
+    void bind( YMenuItem * item, const std::string & shown )
     {
+       yitem = item;
+       ClearLine();
+       ClearState( S_DISABLED );
+       ClearState( S_HIDDEN );
+       ClearState( S_HEADLINE );
 
        YMenuSeparator *separator = dynamic_cast<YMenuSeparator *>(yitem);
        if (separator)
@@ -70,12 +97,12 @@ public:
 
           if ( mi->hidden())
           {
-              yuiDebug() << mi->label() << " hidden" << std::endl;
+              mgaTrace() << mi->label() << " hidden" << std::endl;
               SetState(S_HIDDEN);
           }
           else  if ( !mi->enabled() )
           {
-              yuiDebug() << mi->label() << " disabled" << std::endl;
+              mgaTrace() << mi->label() << " disabled" << std::endl;
               SetState( S_DISABLED );
           }
           else
@@ -85,14 +112,17 @@ public:
 
           // leaving next even if managed into MGAPopupMenu
           if ( yitem->hasChildren() )
-          {   yuiDebug() << mi->label() << " has submenu" << std::endl;
-              Append( new NCTableCol( NCstring( yitem->label() + " ..." ) ) );
+          {   mgaTrace() << mi->label() << " has submenu" << std::endl;
+              Append( new NCTableCol( NCstring( shown + " ..." ) ) );
           }
           else
           {
-            Append( new NCTableCol( NCstring( yitem->label() ) ) );
+            Append( new NCTableCol( NCstring( shown ) ) );
           }
           stripHotkeys();
+
+          label = NClabel( NCstring( shown ) );
+          label.stripHotkey();
        }
     }
 
@@ -120,14 +150,15 @@ public:
         }
         else
         {
-            NClabel l(NCstring(yitem->label()));
-            l.stripHotkey();
-            yuiDebug() << yitem->label() << " hotcol: "<< l.hotpos() <<  " hotkey: " << l.hotkey() << std::endl;
+            const NClabel & l( label );
+            mgaTrace() << yitem->label() << " hotcol: "<< l.hotpos() <<  " hotkey: " << l.hotkey() << std::endl;
+
+            cellStyles->update( tableStyle );
 
             if ( !isSpecial() )
-                w.bkgdset( tableStyle.hotBG( _vstate, NCTableCol::PLAIN ) );
+                w.bkgdset( cellStyles->hotBG( _vstate, NCTableCol::PLAIN ) );
 
-            yuiDebug() << "tableStyle hotcol: " << tableStyle.listStyle().title << " bg: " << tableStyle.hotBG(_vstate, tableStyle.HotCol()) << std::endl;
+            mgaTrace() << "tableStyle hotcol: " << tableStyle.listStyle().title << " bg: " << cellStyles->hotBG( _vstate, tableStyle.HotCol() ) << std::endl;
 
 
             NCTableLine::DrawAt( w, at, tableStyle, active );
@@ -150,6 +181,13 @@ public:
 NCMenu::NCMenu( YWidget * parent )
     : YTree( parent, "", FALSE, FALSE )
     , NCPadWidget( parent )
+    , ownerShortcuts( false )
+    , counters( new NCMGAStats( "NCMenu" ) )
+    , first( 0 )
+    , layoutDirty( true )
+    , contentLines( 0 )
+    , contentWidth( 0 )
+    , separators( 0 )
 {
     yuiDebug() << std::endl;
     // minimum size 3 line 8 coulmn
@@ -161,6 +199,7 @@ NCMenu::NCMenu( YWidget * parent )
 NCMenu::~NCMenu()
 {
     yuiDebug() << std::endl;
+    delete counters;
 }
 
 
@@ -192,17 +231,101 @@ inline NCMenuLine * NCMenu::modifyTreeLine( unsigned idx )
 // Set preferred width
 int NCMenu::preferredWidth()
 {
-  // TODO
-    wsze sze = wsze::max( defsze, wsze( 0, labelWidth() + 2 ) );
+    if ( layoutDirty )
+        layout();
+
     return defsze.W + 4;// border and scroll;
 }
 
 // Set preferred height
 int NCMenu::preferredHeight()
 {
-  //TODO
-    wsze sze = wsze::max( defsze, wsze( 0, labelWidth() + 2 ) );
-    return defsze.H;//6;
+    if ( layoutDirty )
+        layout();
+
+    return defsze.H;
+}
+
+
+wsze NCMenu::contentSize()
+{
+    if ( layoutDirty )
+        layout();
+
+    return wsze( contentLines, contentWidth );
+}
+
+
+void NCMenu::addItem( YItem * item )
+{
+    YTree::addItem( item );
+    layoutDirty = true;
+    counters->add( NCMGAStats::LabelBytes, item->label().size() );
+}
+
+
+void NCMenu::setShortcuts( const NCMGAShortcutLevel & level )
+{
+    shortcuts = level;
+    ownerShortcuts = true;
+}
+
+
+// One pass over the items: rows, indexes and sizes, the display width of
+// every label is measured here only
+void NCMenu::layout()
+{
+    rows.clear();
+    first = 0;
+    separators = 0;
+    contentWidth = 0;
+    idx = 0;
+
+    // YItemIterator iterates over the toplevel items
+    for ( YItemIterator it = itemsBegin(); it < itemsEnd(); ++it )
+    {
+        YItem * item = *it;
+
+        YMGAMenuItem * mi = dynamic_cast<YMGAMenuItem *>( item );
+        if ( mi && mi->hidden() )
+        {
+            item->setIndex( -1 );
+            continue;
+        }
+
+        //set item index explicitely, it is set to -1 by default
+        //which makes selecting items painful
+        item->setIndex( idx++ );
+        rows.push_back( item );
+
+        if ( dynamic_cast<YMenuSeparator *>( item ) )
+        {
+            ++separators;
+            continue;
+        }
+
+        NClabel label( NCstring( item->hasChildren() ? item->label() + " ..." : item->label() ) );
+        label.stripHotkey();
+
+        if ( contentWidth < label.width() )
+            contentWidth = label.width();
+    }
+
+    contentLines = rows.size();
+    idx = 0;
+
+    // hidden items have no shortcut
+    if ( !ownerShortcuts )
+        shortcuts.resolve( rows.begin(), rows.end() );
+
+    // let's assume to have a menu enable scrolling for more than 10 lines
+    // and 40 columns, minimum size 3 line 8 column
+    defsze = wsze( contentLines < 3 ? 3 : ( contentLines > MAX_MENU_LINES ? MAX_MENU_LINES : contentLines ),
+                   contentWidth < 8 ? 8 : ( contentWidth > 40 ? 40 : contentWidth ) );
+
+    mgaDebug() << "lines: " << contentLines << " separators: " << separators << " width: " << contentWidth << std::endl;
+
+    layoutDirty = false;
 }
 
 void NCMenu::setSize( int newwidth, int newheight )
@@ -231,7 +354,7 @@ YMenuItem * NCMenu::getCurrentItem() const
             yitem = cline->YItem();
     }
 
-    yuiDebug() << "-> " << ( yitem ? yitem->label().c_str() : "noitem" ) << std::endl;
+    mgaTrace() << "-> " << ( yitem ? yitem->label().c_str() : "noitem" ) << std::endl;
 
     return yitem;
 }
@@ -272,9 +395,8 @@ void NCMenu::selectItem( YItem *item, bool selected )
     {
         YTree::selectItem( treeItem, selected );
 
-        //this highlights selected item, possibly unpacks the tree
-        //should it be in currently hidden branch
-        myPad()->ShowItem( getTreeLine( at ) );
+        //this highlights selected item, scrolling the window if needed
+        scrollTo( at );
     }
 }
 
@@ -285,7 +407,11 @@ void NCMenu::selectItem( YItem *item, bool selected )
 //		      (overloaded for convenience)
 void NCMenu::selectItem( int index )
 {
-    YItem * item = YTree::itemAt( index );
+    if ( layoutDirty )
+        layout();
+
+    // indexes are rows, hidden items have none (see layout())
+    YItem * item = index >= 0 && index < (int) rows.size() ? rows[index] : 0;
 
     if ( item )
     {
@@ -305,6 +431,13 @@ void NCMenu::rebuildTree()
 }
 
 
+void NCMenu::refresh()
+{
+    layoutDirty = true;
+    rebuildTree();
+}
+
+
 
 
 // Creates empty pad
@@ -318,84 +451,47 @@ NCPad * NCMenu::CreatePad()
 
 bool NCMenu::HasHotkey(int key)
 {
-  yuiDebug() << key << std::endl;
+  mgaTrace() << key << std::endl;
 
-  if ( key < 0 || UCHAR_MAX < key )
-    return false;
+  if ( layoutDirty )
+    layout();
 
-  for (YItemIterator it=itemsBegin(); it!=itemsEnd(); it++)
-  {
-    NClabel label = NCstring((*it)->label());
-    label.stripHotkey();
-    yuiDebug() << label << std::endl;
-    if (label.hasHotkey() && (tolower( key ) == tolower(label.hotkey())))
-      return true;
-  }
-
-  return false;
+  return shortcuts.has( key );
 }
 
 NCursesEvent NCMenu::wHandleHotkey( wint_t key )
 {
-    yuiDebug() << "Key: " << key << std::endl;
-    if ( key >= 0 && key < UCHAR_MAX ) //  < myPad()->setItemByKey( key ) )
+    mgaDebug() << "Key: " << key << std::endl;
+
+    if ( layoutDirty )
+        layout();
+
+    counters->add( NCMGAStats::HotkeyLookups );
+    YMGAMenuItem *mi = dynamic_cast<YMGAMenuItem*> ( shortcuts.find( key ) );
+    if ( !mi )
+      return NCursesEvent::none;
+
+    if ( !mi->enabled() )
     {
-      int hkey = tolower( key );
-      for ( YItemIterator it = itemsBegin(); it < itemsEnd(); ++it )
-      {
-          YMGAMenuItem *mi = dynamic_cast<YMGAMenuItem*> (*it);
-          YUI_CHECK_PTR( mi );
-          if (mi->enabled())
-          {
-            NClabel l (NCstring( mi->label() ));
-            l.stripHotkey();
-            yuiDebug() << mi->label() << " " << l << " hotpos: " << l.hotpos() << " hkey: " <<  l.hotkey() << std::endl;
-            if (tolower(l.hotkey()) == hkey)
-            {
-              selectItem(mi->index());
-              return wHandleInput( KEY_RETURN );
-            }
-          }
-          else
-          {
-            yuiDebug() << mi->label() << " disabled" << std::endl;
-          }
-      }
+      mgaDebug() << mi->label() << " disabled" << std::endl;
+      return NCursesEvent::none;
     }
-    return NCursesEvent::none;
+
+    selectItem( mi, true );
+    return wHandleInput( KEY_RETURN );
 }
 
 
 
-// Creates tree lines and appends them to TreePad
-// (called recursively for each child of an item)
+// Creates a tree line and appends it to TreePad
 void NCMenu::CreateTreeLine( NCTreePad * pad, YItem * item )
 {
-    //set item index explicitely, it is set to -1 by default
-    //which makes selecting items painful
-    item->setIndex( idx++ );
-
     YMenuItem * treeItem = dynamic_cast<YMenuItem *>( item );
     YUI_CHECK_PTR( treeItem );
 
-    // let's assume to have a menu enable scrolling for more than 10 lines
-    int h = defsze.H > 8 ? 10 : defsze.H + 1;
-    // let's assume to have a menu enable scrolling for more than 40 columns
-    int w = int(item->label().length()) <= defsze.W ? defsze.W : (item->label().length() > 39 ? 40 : item->label().length());
-    defsze = wsze( h,  w );
-
-    NCMenuLine * line = new NCMenuLine( treeItem );
+    NCMenuLine * line = new NCMenuLine( treeItem, shortcuts.label( treeItem ), &cellStyles );
     pad->Append( line );
-
-    if (item->selected())
-    {
-        //retrieve position of item
-        int at = treeItem->index();
-
-        //this highlights selected item, possibly unpacks the tree
-        //should it be in currently hidden branch
-        pad->ShowItem( getTreeLine( at ) );
-    }
+    counters->add( NCMGAStats::MenuLinesBuilt );
 
     //line->stripHotkeys();
 }
@@ -407,33 +503,165 @@ YMenuItem * NCMenu::currentItem()
 }
 
 // Fills TreePad with lines (uses CreateTreeLines to create them)
+// Only the lines of the shown window of items are created, they are
+// bound to other items when scrolling (see scrollTo())
 void NCMenu::DrawPad()
 {
+    NCMGATraceSpan span( "NCMenu::DrawPad" );
+
     if ( !myPad() )
     {
         yuiWarning() << "PadWidget not yet created" << std::endl;
         return;
     }
 
-    idx = 0;
-    // YItemIterator iterates over the toplevel items
-    for ( YItemIterator it = itemsBegin(); it < itemsEnd(); ++it )
+    if ( layoutDirty )
+        layout();
+
+    first = 0;
+
+    // no more lines than the terminal left room for
+    unsigned lines = MAX_MENU_LINES;
+    if ( padwin && padwin->height() > 0 && (unsigned) padwin->height() < lines )
+        lines = padwin->height();
+
+    for ( unsigned i = 0; i < rows.size() && i < lines; ++i )
+        CreateTreeLine( myPad(), rows[i] );
+
+    NCPadWidget::DrawPad();
+    counters->add( NCMGAStats::MenuPaints );
+
+    YItem * selected = selectedItem();
+    if ( selected && selected->index() >= 0 )
+        scrollTo( selected->index() );
+}
+
+
+unsigned NCMenu::windowLines() const
+{
+    if ( !myPad() )
+        return 0;
+
+    unsigned lines = myPad()->Lines();
+
+    // the pad window shrinks with the terminal, the pad does not
+    if ( padwin && padwin->height() > 0 && (unsigned) padwin->height() < lines )
+        lines = padwin->height();
+
+    return lines;
+}
+
+
+void NCMenu::scrollTo( unsigned row )
+{
+    if ( !myPad() || row >= rows.size() )
+        return;
+
+    unsigned window = windowLines();
+    if ( window == 0 )
+        return;
+
+    if ( row < first || row >= first + window )
     {
-        CreateTreeLine( myPad(), *it );
+        first = row < first ? row : row - window + 1;
+
+        for ( unsigned line = 0; line < window; ++line )
+        {
+            NCMenuLine * menuLine = modifyTreeLine( line );
+            if ( menuLine )
+                menuLine->bind( dynamic_cast<YMenuItem *>( rows[first + line] ),
+                                shortcuts.label( rows[first + line] ) );
+        }
+
+        myPad()->setFormatDirty();
     }
 
-    idx = 0;
-    NCPadWidget::DrawPad();
+    //this highlights selected item
+    myPad()->ShowItem( getTreeLine( row - first ) );
+}
+
+
+bool NCMenu::scrollRows( wint_t key, unsigned count )
+{
+    if ( !myPad() || rows.empty() )
+        return false;
+
+    // single moves inside the window are left to the pad
+    if ( count == 1 && rows.size() <= windowLines() )
+        return false;
+
+    int window = windowLines();
+    int line = myPad()->CurPos().L;
+    int row = first + line;
+    int last = rows.size() - 1;
+    int steps = count;
+    int target = -1;
+
+    switch ( key )
+    {
+        case KEY_UP:
+            if ( row > 0 && ( steps > 1 || line == 0 ) )
+                target = std::max( row - steps, 0 );
+            break;
+
+        case KEY_DOWN:
+            if ( row < last && ( steps > 1 || line == window - 1 ) )
+                target = std::min( row + steps, last );
+            break;
+
+        case KEY_PPAGE:
+            target = std::max( row - steps * window, 0 );
+            break;
+
+        case KEY_NPAGE:
+            target = std::min( row + steps * window, last );
+            break;
+
+        case KEY_HOME:
+            target = 0;
+            break;
+
+        case KEY_END:
+            target = last;
+            break;
+    }
+
+    if ( target < 0 )
+        return false;
+
+    scrollTo( target );
+
+    return true;
+}
+
+
+int NCMenu::visibleLine( const YItem * item ) const
+{
+    int line   = item->index() - (int) first;
+    int window = windowLines();
+
+    if ( line >= window )
+        line = window - 1;
+
+    return line < 0 ? 0 : line;
 }
 
 
 
 NCursesEvent NCMenu::wHandleInput( wint_t key )
 {
+    NCMGATraceSpan span( "NCMenu::wHandleInput" );
+    NCMGAStats::poll();
+
     NCursesEvent ret = NCursesEvent::none;
     YMenuItem * oldCurrentItem = getCurrentItem();
 
-    bool handled = handleInput( key ); // NCTreePad::handleInput()
+    // keys repeated meanwhile (key repeat, paste) are summed up into one
+    // move, so that only one event is returned for all of them
+    unsigned count = NCMGAInput::isNavigationKey( key ) ? 1 + NCMGAInput::drain( key ) : 1;
+
+    // scrolling the window of lines, otherwise NCTreePad::handleInput()
+    bool handled = scrollRows( key, count ) || handleInput( key );
     const YItem * currentItem = getCurrentItem();
 
     if ( !currentItem )
@@ -469,7 +697,7 @@ NCursesEvent NCMenu::wHandleInput( wint_t key )
           ret = NCursesEvent::SelectionChanged;
     }
 
-    yuiDebug() << "Notify: " << ( notify() ? "true" : "false" ) <<
+    mgaDebug() << "Notify: " << ( notify() ? "true" : "false" ) <<
                " Return event: " << ret.reason << std::endl;
 
     return ret;
@@ -483,5 +711,10 @@ NCursesEvent NCMenu::wHandleInput( wint_t key )
 void NCMenu::deleteAllItems()
 {
     YTree::deleteAllItems();
+    shortcuts.clear();
+    ownerShortcuts = false;
+    rows.clear();
+    first = 0;
+    layoutDirty = true;
     myPad()->ClearTable();
 }
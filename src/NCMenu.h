@@ -28,6 +28,7 @@
 #define NCMenu_h
 
 #include <iosfwd>
+#include <vector>
 
 #include <yui/YTree.h>
 #include <yui/YMenuItem.h>
@@ -35,7 +36,11 @@
 #include <yui/ncurses/NCTreePad.h>
 #include <yui/ncurses/NCTablePad.h>
 
+#include "NCMGAMenuShortcuts.h"
+#include "NCMGACellStyles.h"
+
 class NCMenuLine;
+class NCMGAStats;
 
 
 class NCMenu : public YTree, public NCPadWidget
@@ -47,11 +52,53 @@ private:
     NCMenu( const NCMenu & );
 
     int idx;
+    NCMGAShortcutLevel shortcuts;
+    bool ownerShortcuts;    // set by setShortcuts(), not resolved here
+
+    // cell backgrounds of the lines
+    NCMGACellStyles cellStyles;
+
+    // performance counters, see NCMGAStats
+    NCMGAStats * counters;  // owned
+
+    // visible items, lines exist only for the window starting at 'first'
+    std::vector<YItem *> rows;
+    unsigned first;
+
+    // cached layout, see layout()
+    bool layoutDirty;
+    unsigned contentLines;
+    unsigned contentWidth;
+    unsigned separators;
+
+    /**
+     * Compute rows, item indexes and sizes in one pass over the items.
+     **/
+    void layout();
 
     void CreateTreeLine(NCTreePad* pad, YItem* item);
 
+    /**
+     * Make 'row' (index into rows) the current line, binding the lines
+     * to other items if it is outside the window.
+     **/
+    void scrollTo( unsigned row );
+
+    /**
+     * Handle 'count' presses of the navigation key 'key' at once if they
+     * move out of the window of lines or if there are several of them.
+     * Returns 'false' if 'key' is left to the pad.
+     **/
+    bool scrollRows( wint_t key, unsigned count = 1 );
+
 protected:
 
+    /**
+     * Number of lines the menu shows: the lines of the pad, fewer if the
+     * terminal does not have room for them.
+     **/
+    unsigned windowLines() const;
+
     virtual NCTreePad * myPad() const
     {
         return dynamic_cast<NCTreePad*>( NCPadWidget::myPad() );
@@ -92,8 +139,42 @@ public:
 
     virtual void rebuildTree();
 
+    /**
+     * Show the items again after their labels, enabled or hidden state
+     * have changed.
+     **/
+    void refresh();
+
     virtual YMenuItem * getCurrentItem() const;
 
+    /**
+     * Return the number of shown entries (H) and the display width of the
+     * widest label (W), from the cached layout.
+     **/
+    wsze contentSize();
+
+    /**
+     * Reimplemented from YSelectionWidget to invalidate the layout.
+     **/
+    virtual void addItem( YItem * item );
+
+    /**
+     * Use the shortcuts of 'level' (already resolved by the owner of the
+     * items) instead of resolving them from the labels of the items.
+     **/
+    void setShortcuts( const NCMGAShortcutLevel & level );
+
+    /**
+     * Return the line (relative to the menu) showing 'item', clamped to
+     * the lines actually visible.
+     **/
+    int visibleLine( const YItem * item ) const;
+
+    /**
+     * Performance counters of this menu.
+     **/
+    const NCMGAStats & stats() const { return *counters; }
+
     virtual YMenuItem * currentItem();
 
     virtual void deselectAllItems();
@@ -31,92 +31,174 @@
 #include <yui/ncurses/NCurses.h>
 #include "YMGANCMenuBar.h"
 #include "NCMGAPopupMenu.h"
+#include "NCMGAMenuCascade.h"
+#include "NCMGAMenuShortcuts.h"
+#include "NCMGACommandIndex.h"
+#include "NCMGACommandPalette.h"
+#include "NCMGAStats.h"
+#include "NCMGATrace.h"
+#include "NCMGALog.h"
 #include <yui/ncurses/YNCursesUI.h>
 #include <yui/mga/YMGAMenuItem.h>
 #include <yui/ncurses/NCLabel.h>
 
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+
+// opens the command palette
+#define KEY_PALETTE 0x10 // Ctrl-P
+
+// all the menu bars, see YMGANCMenuBar::dialogAccelerator()
+static std::set<YMGANCMenuBar *> menuBars;
 
 struct __MBItem
 {
   YItem * item;
   wchar_t hotkey;
   wpos pos;
+
+  // cached layout, see YMGANCMenuBar::rebuildLayout()
+  NClabel label;
+  int col;
+  bool hidden;
+  bool enabled;
+  int nav;    // position in Private::navigable or -1
 };
 
 struct YMGANCMenuBar::Private
 {
+  Private()
+  : stats( "YMGANCMenuBar" )
+  {}
+
   std::vector<struct __MBItem*> items;
   __MBItem *selected;
   unsigned nextSerialNo;
-
-
-  __MBItem* getNext()
+  // menu items by serial number (index), slot 0 is unused
+  std::vector<YMenuItem *> serialItems;
+  // serial numbers of deleted items, given to new ones
+  std::vector<unsigned> freeSerials;
+  bool layoutDirty;
+
+  // top level shortcuts, see YMGANCMenuBar::rebuildLayout()
+  NCMGAShortcutLevel shortcuts;
+  std::map<YItem*, __MBItem*> byItem;
+  bool shortcutsDirty;
+  // shortcuts of the submenus, by parent item
+  std::map<YItem*, NCMGAShortcutLevel> levels;
+
+  // batched changes, see YMGANCMenuBar::beginBatch()
+  int batchLevel;
+  bool changesPending;
+  std::set<YItem*> pendingLevels;
+  // levels to update at the end of the batch (0 is the menu bar)
+  std::set<YItem*> changedLevels;
+
+  // submenus created on demand
+  struct Provider
   {
-    if (not selected)
+    SubmenuProvider create;
+    bool loaded;
+  };
+  std::map<YItem*, Provider> providers;
+  NCMGASubmenuLoader loader;
+
+  // command palette, the index is updated when needed: rebuilt if the
+  // top level menus changed, else only the changed menus
+  NCMGACommandIndex commands;
+  bool commandsDirty;
+  std::set<YItem*> commandMenus;
+  NCMGACommandPalette palette;
+
+  // accelerators by key, and keys by item
+  struct Accelerator
+  {
+    YMenuItem * item;
+    bool active;    // item and its parents enabled and visible
+  };
+  std::unordered_map<int, Accelerator> accelerators;
+  std::map<YItem*, int> acceleratorKeys;
+  bool acceleratorsDirty;   // all to update at the end of the batch
+
+  // asynchronous popups
+  bool asyncPopups;
+  NCMGAMenuCascade cascade;
+  // blocking popup being posted, if any
+  NCMGAPopupMenu * popup;
+
+  // segment styles, resolved once per widget state and style set
+  NCstyle::StWidget normal;
+  NCstyle::StWidget active;
+  NCstyle::StWidget disabled;
+  chtype disabledBG;
+  int stylesState;
+  const NCstyle::Style * stylesSet;
+
+  // performance counters, see NCMGAStats
+  NCMGAStats stats;
+
+
+  // give 'item' a serial number, reusing the ones of deleted items
+  void assignSerial( YItem * item )
+  {
+    unsigned serial;
+
+    if ( freeSerials.empty() )
     {
-        for(__MBItem *i : items)
-        {
-          YMGAMenuItem * mi = dynamic_cast<YMGAMenuItem *>(i->item);
-          YUI_CHECK_NEW(mi);
-          if (mi->enabled() && !mi->hidden())
-            return i;
-        }
-        return NULL;
+      serial = ++nextSerialNo;
+      serialItems.resize( nextSerialNo + 1, 0 );
+    }
+    else
+    {
+      serial = freeSerials.back();
+      freeSerials.pop_back();
     }
 
-    bool found = false;
-    for (uint i=0; i < items.size(); i++)
+    item->setIndex( serial );
+    serialItems[serial] = dynamic_cast<YMenuItem *>( item );
+  }
+
+  // navigable (visible and enabled) top level menus, in order
+  std::vector<__MBItem*> navigable;
+
+  void rebuildNavigable()
+  {
+    navigable.clear();
+    for (__MBItem *i : items)
     {
-      if (items[i]->item == selected->item)
-      {
-        found = true;
-      }
-      if (found)
+      i->nav = -1;
+      if (i->enabled && !i->hidden)
       {
-        if (i+1 < items.size())
-        {
-          YMGAMenuItem * mi = dynamic_cast<YMGAMenuItem *>(items[i+1]->item);
-          YUI_CHECK_NEW(mi);
-          if (mi->enabled() && !mi->hidden())
-            return items[i+1];
-        }
+        i->nav = navigable.size();
+        navigable.push_back(i);
       }
     }
+  }
+
+  __MBItem* getNext()
+  {
+    if (navigable.empty())
+      return selected;
 
-    return selected;
+    if (not selected || selected->nav < 0)
+      return navigable.front();
+
+    return navigable[(selected->nav + 1) % navigable.size()];
   };
 
   __MBItem* getPrevious()
   {
-    if (not selected)
-    {
-        for(__MBItem *i : items)
-        {
-          YMGAMenuItem * mi = dynamic_cast<YMGAMenuItem *>(i->item);
-          YUI_CHECK_NEW(mi);
-          if (mi->enabled() && !mi->hidden())
-            return i;
-        }
-        return NULL;
-    }
+    if (navigable.empty())
+      return selected;
 
-    bool found = false;
-    for (uint i=items.size()-1; i >0 ; i--)
-    {
-      if (items[i]->item == selected->item)
-      {
-        found = true;
-      }
-      if (found)
-      {
-        YMGAMenuItem * mi = dynamic_cast<YMGAMenuItem *>(items[i-1]->item);
-        YUI_CHECK_NEW(mi);
-        if (mi->enabled() && !mi->hidden())
-          return items[i-1];
-      }
-    }
+    if (not selected || selected->nav < 0)
+      return navigable.front();
 
-    return selected;
+    return navigable[(selected->nav + navigable.size() - 1) % navigable.size()];
   };
 };
 
@@ -128,15 +210,38 @@ YMGANCMenuBar::YMGANCMenuBar( YWidget * parent )
   YUI_CHECK_NEW ( d );
   d->selected = NULL;
   d->nextSerialNo = 0;
+  d->serialItems.clear();
+  d->freeSerials.clear();
+  d->layoutDirty = true;
+  d->shortcutsDirty = true;
+  d->batchLevel = 0;
+  d->changesPending = false;
+  d->acceleratorsDirty = false;
+  d->commandsDirty = true;
+  d->asyncPopups = false;
+  d->popup = 0;
+  d->disabledBG = 0;
+  d->stylesState = -1;
+  d->stylesSet = 0;
+
+  d->loader.lazy = [this]( YItem * item ) { return lazySubmenu( item ); };
+  d->loader.load = [this]( YItem * item ) { loadSubmenu( item ); };
+  d->loader.shortcuts = [this]( YItem * item ) { return shortcutLevel( item ); };
+  d->cascade.setSubmenuLoader( d->loader );
+  d->cascade.setStats( &d->stats );
 
   defsze= wsze(1,10);
 
+  menuBars.insert( this );
+
   yuiDebug() << std::endl;
 }
 
 
 YMGANCMenuBar::~YMGANCMenuBar()
 {
+  menuBars.erase( this );
+
   for (__MBItem *i : d->items)
     delete i;
   d->items.clear();
@@ -149,12 +254,18 @@ YMGANCMenuBar::~YMGANCMenuBar()
 
 int YMGANCMenuBar::preferredWidth()
 {
+  if (d->layoutDirty)
+    rebuildLayout();
+
   return wGetDefsze().W;
 }
 
 
 int YMGANCMenuBar::preferredHeight()
 {
+  if (d->layoutDirty)
+    rebuildLayout();
+
   return wGetDefsze().H;
 }
 
@@ -167,41 +278,41 @@ void YMGANCMenuBar::setSize( int newwidth, int newheight )
 
 bool YMGANCMenuBar::HasHotkey(int key)
 {
-  yuiDebug() << key << std::endl;
+  mgaTrace() << key << std::endl;
 
-  if ( key < 0 || UCHAR_MAX < key )
-    return false;
+  if (d->layoutDirty)
+    rebuildLayout();
 
-  for (YItemIterator it=itemsBegin(); it!=itemsEnd(); it++)
-  {
-    NClabel label = NCstring((*it)->label());
-    label.stripHotkey();
-    yuiDebug() << label << std::endl;
-    if (label.hasHotkey() && (tolower( key ) == tolower(label.hotkey())))
-      return true;
-  }
+  if (d->shortcuts.has(key))
+    return true;
 
-  return false;
+  return findAccelerator( AcceleratorMeta | towlower( key ) ) != 0;
 }
 
 NCursesEvent YMGANCMenuBar::wHandleHotkey( wint_t key )
 {
-  yuiDebug() << key << std::endl;
+  mgaDebug() << key << std::endl;
   NCursesEvent ret = NCursesEvent::none;
-  __MBItem *sel = NULL;
-  for (struct __MBItem *i : d->items)
+
+  if (d->layoutDirty)
+    rebuildLayout();
+
+  d->stats.add( NCMGAStats::HotkeyLookups );
+  YItem *item = d->shortcuts.find(key);
+  if (!item)
   {
-    if ( (tolower(i->hotkey)) == tolower(key))
-    {
-      sel = i;
-      break;
-    }
+    // menu hotkeys come first, then Alt and function key accelerators
+    ret = acceleratorEvent( AcceleratorMeta | towlower( key ) );
+    if ( ret == NCursesEvent::none )
+      ret = acceleratorEvent( key );
+
+    return ret;
   }
+
+  __MBItem *sel = d->byItem[item];
   YUI_CHECK_NEW(sel);
 
-  YMGAMenuItem *item = dynamic_cast<YMGAMenuItem *>(sel->item);
-  YUI_CHECK_NEW(item);
-  if (!item->enabled())
+  if (sel->hidden || !sel->enabled)
     return NCursesEvent::none;
 
   d->selected = sel;
@@ -213,20 +324,69 @@ NCursesEvent YMGANCMenuBar::wHandleHotkey( wint_t key )
 
 NCursesEvent YMGANCMenuBar::wHandleInput( wint_t key )
 {
-  yuiDebug() << "wHandleInput " << key << std::endl;
+  NCMGATraceSpan span( "YMGANCMenuBar::wHandleInput" );
+  NCMGAStats::poll();
+
+  mgaDebug() << "wHandleInput " << key << std::endl;
   NCursesEvent ret = NCursesEvent::none;
 
+  if ( !d->palette.isOpen() && !d->cascade.isOpen() )
+  {
+    ret = acceleratorEvent( key );
+    if ( ret != NCursesEvent::none )
+      return ret;
+  }
+
+  if ( d->palette.isOpen() )
+  {
+    NCursesEvent ev = d->palette.handleInput( key );
+    if ( ev == NCursesEvent::menu )
+    {
+      ret = NCursesEvent::menu;
+      ret.selection = ev.selection;
+      yuiMilestone() <<  "selection " << ret.selection->index() << "  " << ret.selection->label() << std::endl;
+    }
+
+    return ret;
+  }
+
+  if ( d->cascade.isOpen() )
+  {
+    NCursesEvent ev = d->cascade.handleInput( key );
+    if ( ev == NCursesEvent::menu )
+    {
+      ret = NCursesEvent::menu;
+      ret.selection = ev.selection;
+      yuiMilestone() <<  "selection " << ret.selection->index() << "  " << ret.selection->label() << std::endl;
+    }
+
+    return ret;
+  }
+
   if (itemsBegin() != itemsEnd())
   {
     switch ( key )
     {
       case KEY_LEFT:
-        d->selected = d->getPrevious();
-        wRedraw();
-        break;
       case KEY_RIGHT:
-        d->selected = d->getNext();
-        wRedraw();
+        {
+          bool dirty = d->layoutDirty;
+          if ( dirty )
+            rebuildLayout();
+
+          __MBItem *old = d->selected;
+          d->selected = key == KEY_LEFT ? d->getPrevious() : d->getNext();
+          if ( dirty )
+          {
+            wRedraw();
+          }
+          else if ( win && old != d->selected )
+          {
+            // only the old and the new selected segments change
+            drawSegment( old );
+            drawSegment( d->selected );
+          }
+        }
         break;
       case KEY_HOTKEY:
       case KEY_SPACE:
@@ -234,6 +394,9 @@ NCursesEvent YMGANCMenuBar::wHandleInput( wint_t key )
       case KEY_DOWN:
         ret = postMenu();
         break;
+      case KEY_PALETTE:
+        openCommandPalette();
+        break;
     }
   }
 
@@ -243,39 +406,143 @@ NCursesEvent YMGANCMenuBar::wHandleInput( wint_t key )
 
 void YMGANCMenuBar::addItem(YItem* item)
 {
-  if (itemsBegin() == itemsEnd())
-    defsze = wsze(0,0);
-
   YMGAMenuBar::addItem(item);
 
   __MBItem *it = new( __MBItem);
   it->item = item;
+  it->hotkey = 0;
+  it->col = 0;
+  it->hidden = false;
+  it->enabled = true;
+  it->nav = -1;
   d->items.push_back(it);
+  d->byItem[item] = it;
+  d->layoutDirty = true;
+  d->shortcutsDirty = true;
+  d->commandsDirty = true;
 
-  NClabel label( NCstring( item->label() ));
-  label.stripHotkey();
-
-  unsigned int h = defsze.H > 0 ? defsze.H : 0;
-  defsze = wsze( h < label.height() ? label.height() : h,
-                   defsze.W + label.width()+5 );
-  yuiDebug() <<  "label: " << label << " defsze: " << defsze << std::endl;
-
-  item->setIndex( ++(d->nextSerialNo) );
+  d->assignSerial( item );
 
   if ( item->hasChildren() )
-        assignUniqueIndex( item->childrenBegin(), item->childrenEnd() );
+  {
+    resolveLevel( item );
+    assignUniqueIndex( item->childrenBegin(), item->childrenEnd() );
+  }
 }
 
 void YMGANCMenuBar::addItems(const YItemCollection& itemCollection)
 {
+  NCMGATraceSpan span( "YMGANCMenuBar::addItems" );
+
+  beginBatch();
   YSelectionWidget::addItems(itemCollection);
+  itemsChanged();
+  endBatch();
+}
 
-  wRedraw();
+
+void YMGANCMenuBar::rebuildLayout()
+{
+  if (d->shortcutsDirty)
+  {
+    d->shortcuts.resolve( itemsBegin(), itemsEnd() );
+    d->shortcutsDirty = false;
+  }
+
+  int col = 0;
+  unsigned height = 0;
+  unsigned width = 0;
+  for (__MBItem *i : d->items)
+  {
+    // first item of any YMenuItem is the menu name
+    i->label = NClabel( NCstring( d->shortcuts.label( i->item ) ));
+    i->label.stripHotkey();
+    d->stats.add( NCMGAStats::LabelBytes, i->item->label().size() );
+    i->hotkey = i->label.hotkey();
+
+    // hidden menus keep their room, as the size is not renegotiated
+    if (height < i->label.height())
+      height = i->label.height();
+    width += i->label.width() + 5;
+
+    YMGAMenuItem * mi = dynamic_cast<YMGAMenuItem *>(i->item);
+    i->hidden  = mi && mi->hidden();
+    i->enabled = !mi || mi->enabled();
+
+    if (i->hidden)
+    {
+      mgaTrace() << i->item->label() << " hidden" << std::endl;
+      continue;
+    }
+
+    // "[" label "]"
+    i->col = col;
+    i->pos = wpos( 0, col+1 );
+    col += i->label.width() + 5;
+
+    mgaTrace() <<  i->item->label() << " pos: " << i->pos << " hotkey: " << i->hotkey << std::endl;
+  }
+
+  if (!d->items.empty())
+  {
+    defsze = wsze( height, width );
+    mgaDebug() << "defsze: " << defsze << std::endl;
+  }
+
+  d->rebuildNavigable();
+
+  if (!d->selected && !d->items.empty())
+    d->selected = d->navigable.empty() ? d->items.front() : d->navigable.front();
+
+  d->layoutDirty = false;
+}
+
+
+void YMGANCMenuBar::resolveStyles()
+{
+  const NCstyle::Style * set = &wStyle();
+
+  if ( d->stylesState == (int) GetState() && d->stylesSet == set )
+    return;
+
+  d->normal     = widgetStyle( true );
+  d->active     = widgetStyle( false );
+  d->disabled   = set->disabled;
+  d->disabledBG = set->disabledList.item.plain;
+
+  d->stylesState = GetState();
+  d->stylesSet   = set;
+}
+
+
+void YMGANCMenuBar::drawSegment( __MBItem * sel )
+{
+  if ( !win || !sel || sel->hidden )
+    return;
+
+  resolveStyles();
+
+  const NCstyle::StWidget & style( !sel->enabled       ? d->disabled
+                                   : d->selected != sel ? d->normal
+                                   : d->active );
+  int col = sel->col;
+
+  win->bkgdset( sel->enabled ? style.plain : d->disabledBG );
+  win->printw( 0, col, "[" );
+
+  sel->label.drawAt( *win, style, sel->pos, wsze( -1, sel->label.width() + 3 ), NC::CENTER );
+  col = col + sel->label.width() + 4;
+  win->printw( 0, col, "]" );
+
+  haveUtf8() ? win->add_wch( 0, col - 1, WACS_DARROW )
+  : win->addch( 0, col - 1, ACS_DARROW );
 }
 
 
 void YMGANCMenuBar::wRedraw()
 {
+  NCMGATraceSpan span( "YMGANCMenuBar::wRedraw" );
+
   if ( !win )
     return;
 
@@ -285,103 +552,250 @@ void YMGANCMenuBar::wRedraw()
     return;
   }
 
-  int col=0;
-  for ( YItemConstIterator it = itemsBegin() ; it != itemsEnd(); ++it )
+  if (d->layoutDirty)
+    rebuildLayout();
+
+  resolveStyles();
+  d->stats.add( NCMGAStats::MenuBarPaints );
+
+  int col = 0;
+  for (__MBItem *i : d->items)
   {
-    __MBItem *sel = NULL;
-    for (__MBItem *i : d->items)
-    {
-      if (i->item == *it)
-      {
-        sel = i;
-        break;
-      }
-    }
-    YUI_CHECK_NEW(sel);
-    if (!d->selected)
-      d->selected = sel;
+    if (i->hidden)
+      continue;
 
-    const NCstyle::StWidget & style( widgetStyle(d->selected != sel) );
-    // first item of any YMenuItem is the menu name
-    NClabel label( NCstring( (*it)->label() ));
-    label.stripHotkey();
-    YMGAMenuItem * mi = dynamic_cast<YMGAMenuItem *>(*it);
-    bool disabled = false;
+    drawSegment( i );
+    col = i->col + i->label.width() + 5;
+  }
 
-    if (mi)
-    {
-      if (mi->hidden())
-      {
-        yuiDebug() << mi->label() << " hidden" << std::endl;
-        continue;
-      }
-      else if (!mi->enabled())
-      {
-        disabled = true;
+  if (col < win->width())
+  {
+    win->move(0, col);
+    win->bkgdset( d->normal.plain );
+    win->clrtoeol();
+  }
+}
 
-        yuiDebug() << mi->label() << " disabled" << std::endl;
-        win->bkgdset(wStyle().disabledList.item.plain);
-      }
-      else
-      {
-        win->bkgdset( style.plain );
-      }
 
-    }
-    win->printw( 0, col, "[" );
-    sel->pos = wpos( 0, col+1 );
-    sel->hotkey = label.hotkey();
+void YMGANCMenuBar::setItemLabel( YItem * item, const std::string & label )
+{
+  item->setLabel( label );
+
+  // only the level of the item needs new shortcuts
+  resolveLevel( item->parent() );
+  commandsChanged( item );
+  levelChanged( item->parent() );
+}
 
-    yuiDebug() <<  sel->item->label() << " pos: " << sel->pos << " hotkey: " << sel->hotkey << " defsize: " << defsze << std::endl;
 
-    if (disabled)
-      label.drawAt( *win, wStyle().disabled, sel->pos, wsze( -1, label.width() + 3 ), NC::CENTER );
+void YMGANCMenuBar::resolveLevel( YItem * parent )
+{
+  if ( d->batchLevel > 0 )
+  {
+    if ( parent )
+      d->pendingLevels.insert( parent );
     else
-      label.drawAt( *win, style, sel->pos, wsze( -1, label.width() + 3 ), NC::CENTER );
-    col = col + label.width() + 4;
-    win->printw( 0, col, "]" );
-
-    haveUtf8() ? win->add_wch( 0, col - 1, WACS_DARROW )
-    : win->addch( 0, col - 1, ACS_DARROW );
-    col++;
-    if (col < win->width())
-    {
-      win->move(0, col);
-      win->bkgdset( style.plain );
-      win->clrtoeol();
-    }
+      d->shortcutsDirty = true;
+
+    return;
+  }
+
+  if ( parent )
+    d->levels[parent].resolve( parent->childrenBegin(), parent->childrenEnd() );
+  else
+    d->shortcutsDirty = true;
+}
+
+
+const NCMGAShortcutLevel * YMGANCMenuBar::shortcutLevel( YItem * parent )
+{
+  std::map<YItem*, NCMGAShortcutLevel>::iterator it = d->levels.find( parent );
+
+  // pending in a batch or never resolved
+  if ( it == d->levels.end() || d->pendingLevels.erase( parent ) )
+  {
+    it = d->levels.insert( std::make_pair( parent, NCMGAShortcutLevel() ) ).first;
+    it->second.resolve( parent->childrenBegin(), parent->childrenEnd() );
+  }
+
+  return &it->second;
+}
+
+
+void YMGANCMenuBar::itemsChanged()
+{
+  d->layoutDirty = true;
+
+  if ( d->batchLevel > 0 )
+  {
+    d->changesPending = true;
+    return;
+  }
+
+  d->changesPending = false;
+  d->changedLevels.clear();
+  wRedraw();
+
+  // open menus are rebuilt in place, the other cached ones dropped
+  d->cascade.refresh();
+  if ( d->popup )
+    d->popup->refresh();
+
+  refreshPalette();
+}
+
+
+void YMGANCMenuBar::levelChanged( YItem * parent )
+{
+  if ( d->batchLevel > 0 )
+  {
+    d->changedLevels.insert( parent );
+    return;
+  }
+
+  if ( !parent )
+  {
+    d->layoutDirty = true;
+    wRedraw();
   }
+  else
+  {
+    d->cascade.refresh( parent );
+    if ( d->popup )
+      d->popup->refresh( parent );
+  }
+
+  refreshPalette();
+}
+
+
+void YMGANCMenuBar::commandsChanged( YItem * item )
+{
+  while ( item->parent() )
+    item = item->parent();
+
+  d->commandMenus.insert( item );
+}
+
 
-  #if 0
-  win->vline( ' ', win->maxx() - col +1);
-  win->vline( 0, win->maxx() - 1, win->height(), ' ' );
-  if ( h > 1 )win->vline( 0, win->maxx() - 1, win->height(), ' ' );
+void YMGANCMenuBar::syncCommands()
+{
+  if ( d->commandsDirty )
+  {
+    d->commands.build( itemsBegin(), itemsEnd() );
+    d->commandsDirty = false;
+  }
+  else
   {
-  win->box( wrect( 0, win->size() - wsze( 0, 1 ) ) );
+    for ( YItem * menu : d->commandMenus )
+      d->commands.update( menu );
+  }
+
+  d->commandMenus.clear();
+}
+
+
+void YMGANCMenuBar::refreshPalette()
+{
+  if ( !d->palette.isOpen() )
+    return;
+
+  syncCommands();
+  d->palette.refresh();
+}
+
+
+void YMGANCMenuBar::openCommandPalette()
+{
+  syncCommands();
+
+  d->cascade.close();
+  resolveStyles();
+  d->palette.setStyle( d->normal, d->active );
+  d->palette.open( &d->commands, ScreenPos() + wpos( 1, 0 ), 60 );
+}
+
+
+void YMGANCMenuBar::beginBatch()
+{
+  ++(d->batchLevel);
 }
-#endif
+
+
+void YMGANCMenuBar::endBatch()
+{
+  if ( d->batchLevel <= 0 )
+  {
+    yuiWarning() << "endBatch() without beginBatch()" << std::endl;
+    return;
+  }
+
+  if ( --(d->batchLevel) > 0 )
+    return;
+
+  if ( d->acceleratorsDirty )
+    updateAccelerators();
+
+  for ( YItem * parent : d->pendingLevels )
+  {
+    d->levels[parent].resolve( parent->childrenBegin(), parent->childrenEnd() );
+    d->changedLevels.insert( parent );
+  }
+  d->pendingLevels.clear();
+
+  if ( d->changesPending )
+  {
+    itemsChanged();
+    return;
+  }
+
+  std::set<YItem*> changed;
+  changed.swap( d->changedLevels );
+
+  for ( YItem * parent : changed )
+    levelChanged( parent );
 }
 
 
 NCursesEvent YMGANCMenuBar::postMenu()
 {
+  NCMGATraceSpan span( "YMGANCMenuBar::postMenu" );
+
   if (!d->selected)
     return NCursesEvent::none;
 
-  YMGAMenuItem *item = dynamic_cast<YMGAMenuItem *>(d->selected->item);
-  YUI_CHECK_NEW(item);
-  if (!item->enabled())
+  if (d->layoutDirty)
+    rebuildLayout();
+
+  YItem *item = d->selected->item;
+  if (!d->selected->enabled || d->selected->hidden)
      return NCursesEvent::none;
 
+  loadSubmenu( item );
+
   // add fix heigth of 1 (dont't use win->height() because win might be invalid, bnc#931154)
   wpos at( ScreenPos() + wpos( 1, d->selected->pos.C ) );
-  yuiWarning() <<  " position " << ScreenPos() << " menu position " << at <<std::endl;
+  mgaDebug() <<  " position " << ScreenPos() << " menu position " << at <<std::endl;
+
+  if ( d->asyncPopups )
+  {
+    // the choice is returned later by wHandleInput()
+    d->cascade.close();
+    resolveStyles();
+    d->cascade.setStyle( d->normal, d->active, d->disabled );
+    d->cascade.open( item, item->childrenBegin(), item->childrenEnd(), at );
+
+    return NCursesEvent::none;
+  }
 
-  NCMGAPopupMenu * dialog = new NCMGAPopupMenu( at, item->childrenBegin(), item->childrenEnd() );
+  NCMGAPopupMenu * dialog = new NCMGAPopupMenu( at, item->childrenBegin(), item->childrenEnd(), d->loader );
+  d->stats.add( NCMGAStats::PopupMenus );
 
   YUI_CHECK_NEW( dialog );
 
+  d->popup = dialog;
   int selection = dialog->post();
+  d->popup = 0;
 
   if ( selection < 0 )
   {
@@ -398,7 +812,7 @@ NCursesEvent YMGANCMenuBar::postMenu()
     return NCursesEvent::none;
   }
 
-  yuiMilestone() << dialog->isTopmostDialog() << std::endl;
+  mgaDebug() << dialog->isTopmostDialog() << std::endl;
 
   YDialog::deleteTopmostDialog();
 
@@ -410,32 +824,10 @@ NCursesEvent YMGANCMenuBar::postMenu()
 
 YMenuItem * YMGANCMenuBar::findMenuItem( int index )
 {
-  return findMenuItem( index, itemsBegin(), itemsEnd() );
-}
-
-
-YMenuItem * YMGANCMenuBar::findMenuItem( int wantedIndex, YItemConstIterator begin, YItemConstIterator end )
-{
-  for ( YItemConstIterator it = begin; it != end; ++it )
-  {
-    YMenuItem * item = dynamic_cast<YMenuItem *> (*it);
-
-    if ( item )
-    {
-      if ( item->index() == wantedIndex )
-        return item;
+  if ( index <= 0 || index >= (int) d->serialItems.size() )
+    return 0;
 
-      if ( item->hasChildren() )
-      {
-        YMenuItem * result = findMenuItem( wantedIndex, item->childrenBegin(), item->childrenEnd() );
-
-        if ( result )
-          return result;
-      }
-    }
-  }
-
-  return 0;
+  return d->serialItems[index];
 }
 
 void YMGANCMenuBar::setEnabled( bool do_bv )
@@ -452,103 +844,673 @@ void YMGANCMenuBar::assignUniqueIndex( YItemIterator begin, YItemIterator end )
     {
         YItem * item = *it;
 
-        item->setIndex( ++(d->nextSerialNo) );
+        d->assignSerial( item );
 
         if ( item->hasChildren() )
+        {
+            resolveLevel( item );
             assignUniqueIndex( item->childrenBegin(), item->childrenEnd() );
+        }
     }
 }
 
 
-void YMGANCMenuBar::enableItem(YItem* menu_item, bool enable)
+void YMGANCMenuBar::releaseItems( YItemConstIterator begin, YItemConstIterator end )
 {
-  YMGAMenuBar::enableItem(menu_item, enable);
+  for ( YItemConstIterator it = begin; it != end; ++it )
+  {
+    YItem * item = *it;
+    int index = item->index();
+
+    if ( index > 0 && index < (int) d->serialItems.size() && d->serialItems[index] == item )
+    {
+      d->serialItems[index] = 0;
+      d->freeSerials.push_back( index );
+    }
+
+    d->providers.erase( item );
+
+    if ( !item->parent() )
+    {
+      d->commands.remove( item );
+      d->commandMenus.erase( item );
+    }
+
+    std::map<YItem*, int>::iterator accel = d->acceleratorKeys.find( item );
+    if ( accel != d->acceleratorKeys.end() )
+    {
+      d->accelerators.erase( accel->second );
+      d->acceleratorKeys.erase( accel );
+    }
+
+    if ( item->hasChildren() )
+    {
+      d->cascade.invalidate( item );
+      d->pendingLevels.erase( item );
+      d->levels.erase( item );
+      releaseItems( item->childrenBegin(), item->childrenEnd() );
+    }
+  }
 }
 
-void YMGANCMenuBar::hideItem(YItem* menu_item, bool invisible)
+
+// Key matching an item with its updated version: application data if
+// set, else the label; separators match each other in order
+static std::string matchKey( const YItem * item )
 {
-  YMGAMenuBar::hideItem(menu_item, invisible);
+  if ( dynamic_cast<const YMenuSeparator *>( item ) )
+    return "-";
+
+  if ( item->data() )
+    return "@" + std::to_string( reinterpret_cast<uintptr_t>( item->data() ) );
+
+  return "=" + item->label();
 }
 
-void YMGANCMenuBar::deleteAllItems()
+
+// For every updated item from 'ubegin' to 'uend' find the current item
+// (from 'begin' to 'end') it is a new version of, or 0 if it is a new
+// one. Returns 'false' if items have been added, removed or moved.
+static bool matchItems( YItemIterator begin, YItemIterator end,
+                        YItemConstIterator ubegin, YItemConstIterator uend,
+                        std::vector<YItem *> & matched )
 {
-  for (__MBItem *i : d->items)
-    delete i;
-  d->items.clear();
-  d->selected = NULL;
-  d->nextSerialNo = 0;
+  std::map<std::string, std::deque<YItem *>> current;
 
-  YSelectionWidget::deleteAllItems();
-  //wRedraw();
+  for ( YItemIterator it = begin; it != end; ++it )
+    current[ matchKey( *it ) ].push_back( *it );
+
+  bool same = true;
+  YItemIterator pos = begin;
+
+  matched.clear();
+  for ( YItemConstIterator u = ubegin; u != uend; ++u )
+  {
+    std::deque<YItem *> & candidates = current[ matchKey( *u ) ];
+    YItem * item = 0;
+
+    if ( !candidates.empty() )
+    {
+      item = candidates.front();
+      candidates.pop_front();
+    }
+
+    if ( same && pos != end && item == *pos )
+      ++pos;
+    else
+      same = false;
+
+    matched.push_back( item );
+  }
+
+  return same && pos == end;
 }
 
 
+// Copy 'src' and its children as a new child of 'parent' (a top level
+// item if 0)
+static YItem * cloneItem( YMGAMenuItem * parent, const YItem * src )
+{
+  if ( dynamic_cast<const YMenuSeparator *>( src ) )
+    return new YMenuSeparator( parent );
+
+  YMGAMenuItem * item = parent ? new YMGAMenuItem( parent, src->label(), src->iconName() )
+                               : new YMGAMenuItem( src->label(), src->iconName() );
+  YUI_CHECK_NEW( item );
+
+  const YMGAMenuItem * mi = dynamic_cast<const YMGAMenuItem *>( src );
+  if ( mi )
+  {
+    item->enable( mi->enabled() );
+    item->hide( mi->hidden() );
+  }
 
-static void resolveShortcutsConflictFlat(YItemConstIterator begin, YItemConstIterator end)
+  for ( YItemConstIterator it = src->childrenBegin(); it != src->childrenEnd(); ++it )
+    cloneItem( item, *it );
+
+  return item;
+}
+
+
+bool YMGANCMenuBar::mergeItem( YItem * item, const YItem * update, std::set<YItem *> & levels )
 {
-  bool used[ sizeof( char ) << 8 ];
-  for ( unsigned i=0; i < sizeof( char ) << 8; i++ )
-    used[i] = false;
-  std::vector<YMenuItem*> conflicts;
+  bool changed = false;
 
-  for ( YItemConstIterator it = begin; it != end; ++it )
+  if ( item->label() != update->label() )
   {
-    YMenuItem * item = dynamic_cast<YMenuItem *> (*it);
+    item->setLabel( update->label() );
+    changed = true;
+  }
+
+  if ( item->iconName() != update->iconName() )
+  {
+    item->setIconName( update->iconName() );
+    changed = true;
+  }
 
-    if ( item )
+  YMGAMenuItem * mi = dynamic_cast<YMGAMenuItem *>( item );
+  const YMGAMenuItem * src = dynamic_cast<const YMGAMenuItem *>( update );
+  if ( mi && src )
+  {
+    if ( mi->enabled() != src->enabled() )
     {
-      if ( item->hasChildren() )
-      {
-        resolveShortcutsConflictFlat(item->childrenBegin(), item->childrenEnd() );
-      }
+      mi->enable( src->enabled() );
+      changed = true;
+    }
 
-      char shortcut = YShortcut::normalized(YShortcut::findShortcut(item->label()));
+    if ( mi->hidden() != src->hidden() )
+    {
+      mi->hide( src->hidden() );
+      changed = true;
+    }
+  }
 
-      if (shortcut == 0)
-      {
-        conflicts.push_back(item);
-        yuiMilestone() << "No or invalid shortcut found " << item->label() << endl;
-      }
-      else if (used[(unsigned)shortcut])
-      {
-        conflicts.push_back(item);
-        yuiWarning() << "Conflicting shortcut found " << item->label() << endl;
-      }
-      else
-      {
-        used[(unsigned)shortcut] = true;
-      }
+  // entries of lazy submenus belong to their provider
+  if ( d->providers.count( item ) )
+    return changed;
+
+  std::vector<YItem *> matched;
+  if ( matchItems( item->childrenBegin(), item->childrenEnd(),
+                   update->childrenBegin(), update->childrenEnd(), matched ) )
+  {
+    bool levelChanged = false;
+    YItemConstIterator u = update->childrenBegin();
+
+    for ( YItemIterator it = item->childrenBegin(); it != item->childrenEnd(); ++it, ++u )
+    {
+      if ( mergeItem( *it, *u, levels ) )
+        levelChanged = true;
+    }
+
+    if ( levelChanged )
+      levels.insert( item );
+  }
+  else if ( mi )
+  {
+    yuiDebug() << "Entries of " << item->label() << " added, removed or moved" << std::endl;
+
+    replaceChildren( mi, update->childrenBegin(), update->childrenEnd(), matched, levels );
+    levels.insert( item );
+  }
+  else
+  {
+    yuiWarning() << "Cannot rebuild submenu " << item->label() << std::endl;
+  }
+
+  return changed;
+}
+
+
+// The kept items are taken out of their slots, so that deleting the
+// children deletes only the removed ones, and added again in the new order
+void YMGANCMenuBar::replaceChildren( YMGAMenuItem * item,
+                                     YItemConstIterator ubegin, YItemConstIterator uend,
+                                     const std::vector<YItem *> & matched,
+                                     std::set<YItem *> & levels )
+{
+  std::set<YItem *> kept( matched.begin(), matched.end() );
+  YItemCollection removed;
+
+  for ( YItemIterator it = item->childrenBegin(); it != item->childrenEnd(); ++it )
+  {
+    if ( kept.count( *it ) )
+      *it = 0;
+    else
+      removed.push_back( *it );
+  }
+
+  if ( !removed.empty() )
+    releaseItems( removed.begin(), removed.end() );
+
+  item->deleteChildren();
+  commandsChanged( item );
+
+  YItemCollection added;
+  std::vector<YItem *>::const_iterator old = matched.begin();
+
+  // 'matched' has one slot per update item
+  for ( YItemConstIterator u = ubegin; u != uend && old != matched.end(); ++u, ++old )
+  {
+    if ( *old )
+    {
+      item->addChild( *old );
+      mergeItem( *old, *u, levels );
+    }
+    else
+    {
+      added.push_back( cloneItem( item, *u ) );
+    }
+  }
+
+  assignUniqueIndex( added.begin(), added.end() );
+}
+
+
+// Same as replaceChildren() for the top level menus
+void YMGANCMenuBar::replaceItems( const YItemCollection & itemCollection,
+                                  const std::vector<YItem *> & matched,
+                                  std::set<YItem *> & levels )
+{
+  std::set<YItem *> kept( matched.begin(), matched.end() );
+  YItemCollection removed;
+
+  for ( YItemIterator it = itemsBegin(); it != itemsEnd(); ++it )
+  {
+    if ( kept.count( *it ) )
+      *it = 0;
+    else
+      removed.push_back( *it );
+  }
+
+  if ( !removed.empty() )
+    releaseItems( removed.begin(), removed.end() );
+
+  for ( YItem * item : removed )
+  {
+    __MBItem * i = d->byItem[item];
+    if ( d->selected == i )
+      d->selected = NULL;
+
+    d->byItem.erase( item );
+    delete i;
+  }
+  d->items.clear();
+
+  YSelectionWidget::deleteAllItems();
+
+  std::vector<__MBItem *> items;
+  YItemCollection::const_iterator u = itemCollection.begin();
+
+  for ( YItem * old : matched )
+  {
+    YItem * item = old;
+
+    if ( old )
+    {
+      // addItem() numbers the items by position, the serial is kept
+      int index = old->index();
+      YMGAMenuBar::addItem( old );
+      old->setIndex( index );
+      mergeItem( old, *u, levels );
     }
     else
     {
-      yuiWarning() << "non menu item used in call " << (*it)->label() << endl;
+      item = cloneItem( 0, *u );
+      addItem( item );
     }
+
+    items.push_back( d->byItem[item] );
+    ++u;
   }
 
-  // cannot use YShortcut directly as YItem is not YWidget
-  for(YMenuItem *i: conflicts)
+  d->items.swap( items );
+  d->layoutDirty = true;
+  d->commandsDirty = true;
+}
+
+
+void YMGANCMenuBar::updateItems( const YItemCollection & itemCollection )
+{
+  std::set<YItem *> levels;
+  std::vector<__MBItem *> touched;
+  bool layoutChanged = false;
+  std::vector<YItem *> matched;
+
+  if ( !matchItems( itemsBegin(), itemsEnd(), itemCollection.begin(), itemCollection.end(), matched ) )
   {
-    std::string clean = YShortcut::cleanShortcutString(i->label());
-    char new_c = 0;
+    yuiDebug() << "Top level menus added, removed or moved" << std::endl;
 
-    size_t index = 0;
-    for (; index < clean.size(); ++index)
+    beginBatch();
+    replaceItems( itemCollection, matched, levels );
+    updateAccelerators();
+    for ( YItem * level : levels )
+      resolveLevel( level );
+    resolveLevel( 0 );
+    itemsChanged();
+    endBatch();
+
+    return;
+  }
+
+  YItemCollection::const_iterator update = itemCollection.begin();
+  for ( __MBItem * i : d->items )
+  {
+    std::string label = i->item->label();
+    YMGAMenuItem * mi = dynamic_cast<YMGAMenuItem *>( i->item );
+    bool hidden = mi && mi->hidden();
+
+    if ( mergeItem( i->item, *update, levels ) )
     {
-      char ch = YShortcut::normalized(clean[index]);
-      // ch is set to 0 by normalized if not valid
-      if (ch != 0 && !used[(unsigned)ch])
-      {
-        new_c = ch;
-        used[(unsigned)ch] = true;
-        break;
-      }
+      touched.push_back( i );
+
+      if ( label != i->item->label() || hidden != ( mi && mi->hidden() ) )
+        layoutChanged = true;
     }
 
-    if (new_c != 0)
+    ++update;
+  }
+
+  for ( __MBItem * i : touched )
+    commandsChanged( i->item );
+
+  for ( YItem * level : levels )
+    commandsChanged( level );
+
+  if ( !touched.empty() || !levels.empty() )
+    updateAccelerators();
+
+  for ( YItem * level : levels )
+    resolveLevel( level );
+
+  if ( layoutChanged || d->batchLevel > 0 )
+  {
+    resolveLevel( 0 );
+    itemsChanged();
+    return;
+  }
+
+  // the segments do not move, repaint just the changed ones
+  if ( !touched.empty() )
+  {
+    d->layoutDirty = true;
+    rebuildLayout();
+
+    for ( __MBItem * i : touched )
+      drawSegment( i );
+  }
+
+  for ( YItem * level : levels )
+    levelChanged( level );
+}
+
+
+void YMGANCMenuBar::dropChildren( YItem * item )
+{
+  YMenuItem * menuItem = dynamic_cast<YMenuItem *>( item );
+  YUI_CHECK_PTR( menuItem );
+
+  releaseItems( item->childrenBegin(), item->childrenEnd() );
+  menuItem->deleteChildren();
+  commandsChanged( item );
+}
+
+
+void YMGANCMenuBar::setSubmenuProvider( YItem * item, SubmenuProvider provider )
+{
+  YUI_CHECK_PTR( item );
+
+  // current children are kept as the loaded submenu
+  d->providers[item].create = provider;
+  d->providers[item].loaded = item->hasChildren();
+  d->cascade.invalidate( item );
+
+  // the parent menu shows it as a submenu now
+  if ( item->parent() )
+    levelChanged( item->parent() );
+}
+
+
+void YMGANCMenuBar::invalidateSubmenu( YItem * item )
+{
+  std::map<YItem*, Private::Provider>::iterator it = d->providers.find( item );
+  if ( it == d->providers.end() || !it->second.loaded )
+    return;
+
+  d->cascade.invalidate( item );
+  dropChildren( item );
+  it->second.loaded = false;
+  refreshPalette();
+}
+
+
+bool YMGANCMenuBar::lazySubmenu( YItem * item ) const
+{
+  std::map<YItem*, Private::Provider>::const_iterator it = d->providers.find( item );
+
+  return it != d->providers.end() && !it->second.loaded;
+}
+
+
+void YMGANCMenuBar::loadSubmenu( YItem * item )
+{
+  std::map<YItem*, Private::Provider>::iterator it = d->providers.find( item );
+  if ( it == d->providers.end() || it->second.loaded )
+    return;
+
+  YMGAMenuItem * parent = dynamic_cast<YMGAMenuItem *>( item );
+  YUI_CHECK_PTR( parent );
+
+  it->second.loaded = true;
+  if ( it->second.create )
+    it->second.create( parent );
+
+  yuiDebug() << "Submenu " << item->label() << " created on demand" << std::endl;
+
+  resolveLevel( item );
+  assignUniqueIndex( parent->childrenBegin(), parent->childrenEnd() );
+  commandsChanged( item );
+}
+
+
+void YMGANCMenuBar::setItemAccelerator( YItem * item, int key )
+{
+  YUI_CHECK_PTR( item );
+
+  std::map<YItem*, int>::iterator old = d->acceleratorKeys.find( item );
+  if ( old != d->acceleratorKeys.end() )
+  {
+    d->accelerators.erase( old->second );
+    d->acceleratorKeys.erase( old );
+  }
+
+  if ( key == 0 )
+    return;
+
+  if ( key & AcceleratorMeta )
+    key = AcceleratorMeta | towlower( key & ~AcceleratorMeta );
+
+  YMenuItem * menuItem = dynamic_cast<YMenuItem *>( item );
+  YUI_CHECK_PTR( menuItem );
+
+  std::unordered_map<int, Private::Accelerator>::iterator taken = d->accelerators.find( key );
+  if ( taken != d->accelerators.end() )
+  {
+    yuiWarning() << "Accelerator " << key << " moved from " << taken->second.item->label()
+                 << " to " << item->label() << std::endl;
+    d->acceleratorKeys.erase( taken->second.item );
+  }
+
+  d->accelerators[key].item = menuItem;
+  d->acceleratorKeys[item] = key;
+  updateAccelerators( item );
+}
+
+
+NCursesEvent YMGANCMenuBar::acceleratorEvent( int key ) const
+{
+  NCursesEvent ret = NCursesEvent::none;
+  YMenuItem * accel = findAccelerator( key );
+
+  if ( accel )
+  {
+    ret = NCursesEvent::menu;
+    ret.selection = accel;
+    yuiMilestone() <<  "accelerator " << accel->label() << std::endl;
+  }
+
+  return ret;
+}
+
+
+bool YMGANCMenuBar::HasFunctionHotkey( int key ) const
+{
+  return key >= KEY_F( 1 ) && key <= KEY_F( 24 ) && findAccelerator( key ) != 0;
+}
+
+
+NCursesEvent YMGANCMenuBar::dialogAccelerator( YWidget * widget, wint_t key )
+{
+  YDialog * dialog = widget->findDialog();
+
+  for ( YMGANCMenuBar * bar : menuBars )
+  {
+    if ( bar == widget || bar->findDialog() != dialog )
+      continue;
+
+    if ( key == KEY_PALETTE && bar->itemsBegin() != bar->itemsEnd() )
     {
-      clean.insert(index, 1, YShortcut::shortcutMarker());
-      yuiMilestone() << "New label used: " << clean << endl;
+      // the palette gets its keys through the menu bar
+      if ( bar->grabFocus() )
+        bar->openCommandPalette();
+
+      return NCursesEvent::none;
     }
-    i->setLabel(clean);
+
+    NCursesEvent ret = bar->acceleratorEvent( key );
+    if ( ret != NCursesEvent::none )
+      return ret;
   }
+
+  return NCursesEvent::none;
+}
+
+
+YMenuItem * YMGANCMenuBar::findAccelerator( int key ) const
+{
+  std::unordered_map<int, Private::Accelerator>::const_iterator it = d->accelerators.find( key );
+  d->stats.add( NCMGAStats::AcceleratorLookups );
+
+  return it != d->accelerators.end() && it->second.active ? it->second.item : 0;
+}
+
+
+// An accelerator works if its entry and all the menus above it are
+// enabled and visible
+static bool acceleratorActive( YItem * item )
+{
+  for ( YItem * i = item; i; i = i->parent() )
+  {
+    YMGAMenuItem * mi = dynamic_cast<YMGAMenuItem *>( i );
+    if ( mi && ( !mi->enabled() || mi->hidden() ) )
+      return false;
+  }
+
+  return true;
+}
+
+
+// Only the accelerators of 'item' and of the entries below it can change
+void YMGANCMenuBar::updateAccelerators( YItem * item )
+{
+  if ( d->accelerators.empty() )
+    return;
+
+  if ( d->batchLevel > 0 )
+  {
+    d->acceleratorsDirty = true;
+    return;
+  }
+
+  if ( !item )
+  {
+    for ( auto & accelerator : d->accelerators )
+      accelerator.second.active = acceleratorActive( accelerator.second.item );
+
+    d->acceleratorsDirty = false;
+    return;
+  }
+
+  std::map<YItem*, int>::const_iterator key = d->acceleratorKeys.find( item );
+  if ( key != d->acceleratorKeys.end() )
+    d->accelerators[key->second].active = acceleratorActive( item );
+
+  for ( YItemIterator it = item->childrenBegin(); it != item->childrenEnd(); ++it )
+    updateAccelerators( *it );
+}
+
+
+void YMGANCMenuBar::enableItem(YItem* menu_item, bool enable)
+{
+  YMGAMenuBar::enableItem(menu_item, enable);
+  updateAccelerators( menu_item );
+  commandsChanged( menu_item );
+  levelChanged( menu_item->parent() );
+}
+
+void YMGANCMenuBar::hideItem(YItem* menu_item, bool invisible)
+{
+  YMGAMenuBar::hideItem(menu_item, invisible);
+  // hidden entries have no shortcut
+  resolveLevel( menu_item->parent() );
+  updateAccelerators( menu_item );
+  commandsChanged( menu_item );
+  levelChanged( menu_item->parent() );
+}
+
+void YMGANCMenuBar::deleteAllItems()
+{
+  for (__MBItem *i : d->items)
+    delete i;
+  d->items.clear();
+  d->byItem.clear();
+  d->selected = NULL;
+  d->nextSerialNo = 0;
+  d->serialItems.clear();
+  d->freeSerials.clear();
+  d->shortcuts.clear();
+  d->shortcutsDirty = true;
+  d->levels.clear();
+  d->pendingLevels.clear();
+  d->changedLevels.clear();
+  d->providers.clear();
+  d->accelerators.clear();
+  d->acceleratorKeys.clear();
+  d->acceleratorsDirty = false;
+  d->palette.close();
+  d->commands.clear();
+  d->commandsDirty = true;
+  d->layoutDirty = true;
+  d->cascade.invalidate();
+
+  YSelectionWidget::deleteAllItems();
+  //wRedraw();
+}
+
+
+void YMGANCMenuBar::setAsyncPopups( bool async )
+{
+  d->cascade.close();
+  d->asyncPopups = async;
+}
+
+
+void YMGANCMenuBar::SetState( const NC::WState newstate, const bool force )
+{
+  // the focus moved to another widget
+  if ( newstate != NC::WSactive )
+    closePopups();
+
+  NCWidget::SetState( newstate, force );
+}
+
+
+void YMGANCMenuBar::closePopups()
+{
+  if ( d->cascade.isOpen() )
+    d->cascade.close();
+
+  if ( d->palette.isOpen() )
+    d->palette.close();
+}
+
+
+bool YMGANCMenuBar::asyncPopups() const
+{
+  return d->asyncPopups;
+}
+
+
+const NCMGAStats & YMGANCMenuBar::stats() const
+{
+  return d->stats;
 }
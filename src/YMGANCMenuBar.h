@@ -26,10 +26,18 @@
 #define YMGANMenuBar_h
 
 #include <yui/mga/YMGAMenuBar.h>
+#include <yui/mga/YMGAMenuItem.h>
 #include <yui/ncurses/NCWidget.h>
 #include <yui/YUI.h>
 #include <yui/YApplication.h>
 
+#include <functional>
+#include <set>
+
+struct __MBItem;
+class NCMGAShortcutLevel;
+class NCMGAStats;
+
 class YMGANCMenuBar : public YMGAMenuBar, public NCWidget
 {
 private:
@@ -47,6 +55,17 @@ protected:
 
     virtual void wRedraw();
 
+    /**
+     * Reimplemented from NCWidget to close the open menus and the command
+     * palette when the focus moves to another widget.
+     **/
+    virtual void SetState( const NC::WState newstate, const bool force = false ) override;
+
+    /**
+     * Repaint the segment ("[label]") of a single top level menu.
+     **/
+    void drawSegment( __MBItem * item );
+
     NCursesEvent postMenu();
 
 public:
@@ -62,6 +81,12 @@ public:
     virtual NCursesEvent wHandleHotkey( wint_t key );
     virtual NCursesEvent wHandleInput( wint_t key );
 
+    /**
+     * Reimplemented from NCWidget: function key accelerators, so that the
+     * dialog sends them here from any widget.
+     **/
+    virtual bool HasFunctionHotkey( int key ) const;
+
     virtual bool setKeyboardFocus()
     {
       if ( !grabFocus() )
@@ -114,20 +139,140 @@ public:
      **/
     virtual void deleteAllItems();
 
-private:
     /**
-     * Recursively find the first menu item with the specified index.
-     * Returns 0 if there is no such item.
+     * Change the label of a menu item (menu name or menu entry) and
+     * update the menu bar accordingly.
      **/
-    YMenuItem * findMenuItem( int index );
+    void setItemLabel( YItem * item, const std::string & label );
 
     /**
-     * Recursively find the first menu item with the specified index
-     * from iterator 'begin' to iterator 'end'.
+     * Function creating the entries of a submenu on demand, as children
+     * of 'parent' (e.g. new YMGAMenuItem( parent, label )).
+     **/
+    typedef std::function<void( YMGAMenuItem * parent )> SubmenuProvider;
+
+    /**
+     * Let 'provider' create the entries of the submenu of 'item' when it
+     * is opened for the first time, instead of adding them up front. The
+     * entries are kept until invalidateSubmenu() is called.
+     *
+     * Current children of 'item', if any, are kept and shown as if the
+     * provider had created them: the next invalidateSubmenu() deletes
+     * them as well, so callers must not keep pointers to them.
+     **/
+    void setSubmenuProvider( YItem * item, SubmenuProvider provider );
+
+    /**
+     * Delete the entries of the submenu of 'item' (created by its provider
+     * or already there when it was set), they are created again by the
+     * provider next time the submenu is opened.
+     **/
+    void invalidateSubmenu( YItem * item );
+
+    /**
+     * Update the menus to match 'itemCollection'. Unlike addItems() the
+     * items are not taken over: they still belong to the caller, which
+     * has to delete them, and are copied where needed.
      *
+     * In every menu the items are matched by their data (see
+     * YItem::setData()) if set, else by label, separators in order:
+     * labels, icons and enabled/hidden state of matched items are changed
+     * in place, so that they keep their index, and only the entries that
+     * have been added or removed are created or deleted. Only the
+     * changed menu bar segments and menus are updated.
+     **/
+    void updateItems( const YItemCollection & itemCollection );
+
+    /**
+     * Start a batch of changes (addItem(), enableItem(), hideItem(),
+     * setItemLabel()...). Layout, shortcut resolution and repaint of the
+     * menu bar and of the open menus are deferred until the matching
+     * endBatch(), so that many changes cost one update. Batches can be
+     * nested.
+     **/
+    void beginBatch();
+
+    /**
+     * Close a batch of changes started by beginBatch(); the outermost one
+     * applies all the pending changes.
+     **/
+    void endBatch();
+
+    /**
+     * Reimplemented from YWidget, see beginBatch() and endBatch().
+     **/
+    virtual void startMultipleChanges() { beginBatch(); }
+    virtual void doneMultipleChanges()  { endBatch(); }
+
+    /**
+     * Modifier flag for accelerators triggered with Alt (Meta), e.g.
+     * AcceleratorMeta | 'q' for Alt-Q.
+     **/
+    static const int AcceleratorMeta = 0x40000000;
+
+    /**
+     * Set the accelerator 'key' of the menu entry 'item': pressing it sends
+     * NCursesEvent::menu for 'item' directly, without opening its menu,
+     * as long as the entry and all its parent menus are enabled and
+     * visible. 'key' is a curses key code (e.g. KEY_F(5) or a control
+     * character) or AcceleratorMeta | letter; 0 removes the accelerator.
+     *
+     * Alt and function key accelerators work from any widget of the
+     * dialog (like hotkeys). The other ones (e.g. control characters)
+     * work while the menu bar has the focus, and from widgets passing
+     * the keys they do not use to dialogAccelerator().
+     **/
+    void setItemAccelerator( YItem * item, int key );
+
+    /**
+     * Return the event of the accelerator 'key' of a menu bar in the same
+     * dialog as 'widget' (NCursesEvent::menu), or NCursesEvent::none.
+     * For Ctrl-P that menu bar takes the focus and opens its command
+     * palette. Widgets call this for the keys they do not handle
+     * themselves.
+     **/
+    static NCursesEvent dialogAccelerator( YWidget * widget, wint_t key );
+
+    /**
+     * Open the command palette below the menu bar: typed text is matched
+     * against all the enabled and visible actions of the menus and the
+     * chosen one is returned by wHandleInput() as NCursesEvent::menu, as
+     * if it had been selected from its menu. Ctrl-P opens it as well,
+     * from the menu bar or from widgets passing it to dialogAccelerator().
+     **/
+    void openCommandPalette();
+
+    /**
+     * Enable or disable asynchronous popups.
+     *
+     * By default a menu is posted as a popup dialog running its own
+     * (blocking) event loop until a choice is made.
+     *
+     * If enabled opening a menu returns immediately and the menu levels
+     * are shown by a cascade owned by the menu bar: keys are received
+     * through the normal dialog event loop and the choice is returned
+     * later as NCursesEvent::menu, so that application timers and the
+     * other widgets keep working meanwhile. Open menus are closed when
+     * the menu bar loses the focus.
+     **/
+    void setAsyncPopups( bool async = true );
+
+    /**
+     * Return 'true' if popups are asynchronous.
+     **/
+    bool asyncPopups() const;
+
+    /**
+     * Performance counters of this menu bar.
+     **/
+    const NCMGAStats & stats() const;
+
+private:
+    /**
+     * Find the menu item with the specified index (serial number).
      * Returns 0 if there is no such item.
      **/
-    YMenuItem * findMenuItem( int index, YItemConstIterator begin, YItemConstIterator end );
+    YMenuItem * findMenuItem( int index );
 
     /**
      * Alias for findMenuItem(). Reimplemented to ensure consistent behaviour
@@ -139,6 +284,129 @@ private:
 
     void assignUniqueIndex( YItemIterator begin, YItemIterator end );
 
+    /**
+     * Forget the indexes and cached menus of the items from 'begin' to
+     * 'end' and of their children, before they are deleted.
+     **/
+    void releaseItems( YItemConstIterator begin, YItemConstIterator end );
+
+    /**
+     * Update 'item' and its children in place from 'update', see
+     * updateItems(). The items whose children changed are added to
+     * 'levels'. Returns 'true' if 'item' itself changed.
+     **/
+    bool mergeItem( YItem * item, const YItem * update, std::set<YItem *> & levels );
+
+    /**
+     * Make the children of 'item' match the updated ones from 'ubegin' to
+     * 'uend': 'matched' is the current item of each updated one, or 0 if
+     * it is new. Unmatched children are deleted, new ones copied.
+     **/
+    void replaceChildren( YMGAMenuItem * item,
+                          YItemConstIterator ubegin, YItemConstIterator uend,
+                          const std::vector<YItem *> & matched,
+                          std::set<YItem *> & levels );
+
+    /**
+     * Same as replaceChildren() for the top level menus.
+     **/
+    void replaceItems( const YItemCollection & itemCollection,
+                       const std::vector<YItem *> & matched,
+                       std::set<YItem *> & levels );
+
+    /**
+     * Return 'true' if the submenu of 'item' has a provider and has not
+     * been created yet.
+     **/
+    bool lazySubmenu( YItem * item ) const;
+
+    /**
+     * Create the submenu of 'item' through its provider, if needed.
+     **/
+    void loadSubmenu( YItem * item );
+
+    /**
+     * Delete the children of 'item', forgetting their indexes.
+     **/
+    void dropChildren( YItem * item );
+
+    /**
+     * Update the state of the accelerators of 'item' and of its
+     * children, or of all of them if 'item' is 0. Deferred to the end of
+     * the current batch, if any.
+     **/
+    void updateAccelerators( YItem * item = 0 );
+
+    /**
+     * Close the open menus and the command palette, if any.
+     **/
+    void closePopups();
+
+    /**
+     * Index the actions of the top level menu containing 'item' again
+     * before the command palette is used next.
+     **/
+    void commandsChanged( YItem * item );
+
+    /**
+     * Bring the command index up to date.
+     **/
+    void syncCommands();
+
+    /**
+     * Search the command palette again if it is open, e.g. after items
+     * have changed.
+     **/
+    void refreshPalette();
+
+    /**
+     * Return the event of the active accelerator 'key', if any.
+     **/
+    NCursesEvent acceleratorEvent( int key ) const;
+
+    /**
+     * Return the item of the active accelerator 'key' or 0.
+     **/
+    YMenuItem * findAccelerator( int key ) const;
+
+    /**
+     * Compute columns, decoded labels, hotkeys and state of the top level
+     * menus. This is only needed after items, labels or enabled/hidden
+     * state have changed.
+     **/
+    void rebuildLayout();
+
+    /**
+     * Resolve the styles used to paint the top level menus. This is only
+     * done again after the widget state or the style set has changed.
+     **/
+    void resolveStyles();
+
+    /**
+     * Resolve the shortcuts of the children of 'parent' (the top level
+     * menus if 0), now or at the end of the current batch.
+     **/
+    void resolveLevel( YItem * parent );
+
+    /**
+     * Return the shortcuts of the children of 'parent', resolving them
+     * now if they are not up to date.
+     **/
+    const NCMGAShortcutLevel * shortcutLevel( YItem * parent );
+
+    /**
+     * Update menu bar and open menus after items have changed, now or at
+     * the end of the current batch.
+     **/
+    void itemsChanged();
+
+    /**
+     * Update what shows the children of 'parent' (the menu bar if 0)
+     * after their labels, enabled or hidden state have changed, now or at
+     * the end of the current batch. Other menus are left alone.
+     **/
+    void levelChanged( YItem * parent );
+
     struct Private;
     Private *d;
 };
@@ -24,10 +24,21 @@
 #define  YUILogComponent "mga-ncurses"
 #include <yui/YUILog.h>
 #include "YMGA_NCCBTable.h"
+#include "NCMGAMenuCascade.h"
+#include "YMGANCMenuBar.h"
+#include "NCMGACellStyles.h"
+#include "NCMGAInput.h"
+#include "NCMGAStats.h"
+#include "NCMGATrace.h"
+#include "NCMGALog.h"
 #include <yui/ncurses/NCPopupMenu.h>
 #include <yui/YMenuButton.h>
 #include <yui/YTypes.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
 using std::string;
 using std::vector;
 using std::endl;
@@ -92,6 +103,105 @@ public:
 };
 
 
+/**
+ * Table pad that paints only the columns around the visible part of the
+ * table instead of all of them.
+ *
+ * The pad keeps the start of every column as prefix sums, so the columns
+ * that intersect a horizontal range are found with a binary search. A
+ * full redraw paints the visible columns plus one screen width on either
+ * side; a horizontal scroll paints just the columns it brings in and
+ * otherwise only shifts the pad. A vertical scroll scrolls the window
+ * the pad is shown in, so only the lines it brings in are copied.
+ **/
+class NCColSelTablePad : public NCTablePad
+{
+public:
+
+  NCColSelTablePad( int lines, int cols, const NCWidget & p )
+    : NCTablePad( lines, cols, p )
+    , _first( 1 )
+    , _last( 0 )
+    , _frame( 1 )
+    , _shown( -1, -1 )
+  {
+  }
+
+  virtual ~NCColSelTablePad() {}
+
+  /**
+   * Return 'true' if the range of painted columns is known.
+   **/
+  bool hasColumns() const { return _first <= _last; }
+
+  unsigned firstColumn() const { return _first; }
+
+  unsigned lastColumn() const { return _last; }
+
+  /**
+   * Pad column where column 'col' starts.
+   **/
+  int columnStart( unsigned col ) const { return _starts[ col ]; }
+
+  /**
+   * Number of the current full redraw. Everything painted before it has
+   * been cleared from the pad.
+   **/
+  unsigned frame() const { return _frame; }
+
+  virtual int setpos( const wpos & newpos ) override;
+
+  /**
+   * Repaint line 'lineNo' only and show it.
+   **/
+  void redrawLine( unsigned lineNo );
+
+  /**
+   * Return the line the cursor ends up on after 'count' presses of the
+   * navigation key 'key' (see NCMGAInput::isNavigationKey()), clamped to
+   * the table like the pad's own key handler does.
+   **/
+  int lineAfter( wint_t key, unsigned count ) const;
+
+  /**
+   * Also let ncurses use the terminal insert/delete line feature for
+   * 'dwin', so that scrolling the table shifts the lines on the terminal
+   * instead of sending all of them again.
+   **/
+  virtual void Destwin( NCursesWindow * dwin ) override;
+
+  /**
+   * If only the visible lines moved since the last update, scroll the
+   * destination window by as many rows before the pad is copied to it:
+   * the copy then changes just the rows that scrolled in.
+   **/
+  virtual int update() override;
+
+protected:
+
+  virtual void prepareRedraw() override;
+
+private:
+
+  /**
+   * Return the column at pad column 'x' (the separator in front of a
+   * column belongs to the previous one).
+   **/
+  unsigned columnAt( int x ) const;
+
+  /**
+   * Paint the columns from 'first' to 'last' of all the lines.
+   **/
+  void paintColumns( unsigned first, unsigned last );
+
+  std::vector<int> _starts;     // column starts, then the table width
+  unsigned         _first;      // painted columns
+  unsigned         _last;
+  unsigned         _frame;
+  wpos             _shown;      // pad position in the destination window
+};
+
+
 class NCColSelTableLine : public NCTableLine
 {
 
@@ -100,6 +210,7 @@ public:
   NCColSelTableLine( NCColSelTableLine *        parentLine,
                      YItem *                    yitem,
                      std::vector<NCTableCol*> & cells,
+                     NCMGACellStyles *          cellStyles,
                      int                        index  = -1,
                      bool                       nested = false,
                      unsigned                   state  = S_NORMAL )
@@ -109,7 +220,12 @@ public:
                   index,
                   nested,
                   state)
+    , _cellStyles( cellStyles )
     , _activeColumn( 0 )
+    , _renderedFrame( 0 )
+    , _renderedRow( -1 )
+    , _renderedState( 0 )
+    , _renderedActive( false )
 
       {
       }
@@ -121,66 +237,59 @@ public:
 
     virtual unsigned int activeColumn() { return _activeColumn; }
 
-protected:
-  // reimplemented to get a single selected column
-  virtual void DrawItems( NCursesWindow & w,
-                          const wrect     at,
-                          NCTableStyle &  tableStyle,
-                          bool            active ) const
+  /**
+   * Draw the cells of the columns from 'first' to 'last' (both included)
+   * into the line area 'at', column 'first' starting at window column
+   * 'x'. The rest of the line is not touched, so that columns can be
+   * added to a line that is already painted.
+   **/
+  void drawColumns( NCursesWindow & w,
+                    const wrect     at,
+                    NCTableStyle &  tableStyle,
+                    bool            active,
+                    unsigned        first,
+                    unsigned        last,
+                    int             x ) const
   {
-    if ( !( at.Sze > wsze( 0 ) ) )
-      return;
+    const int      right    = at.Pos.C + at.Sze.W;
+    const unsigned sepWidth = tableStyle.ColSepWidth();
 
-    wrect    lRect( at );
-    unsigned destWidth;
+    _cellStyles->update( tableStyle );
+    const chtype separatorBG = _cellStyles->bg( _vstate, NCTableCol::SEPARATOR );
 
-    for ( unsigned col = 0; col < Cols(); ++col )
+    for ( unsigned col = first; col <= last && col < Cols() && x < right; ++col )
     {
-      if ( col > 0 && tableStyle.ColSepWidth() )
-      {
-        // draw centered
-        destWidth = tableStyle.ColSepWidth() / 2;
+      const int destWidth = tableStyle.ColWidth( col );
 
-        if ( destWidth < (unsigned) lRect.Sze.W )
-        {
-          w.bkgdset( tableStyle.getBG( _vstate, NCTableCol::SEPARATOR ) );
-          w.vline( lRect.Pos.L, lRect.Pos.C + destWidth,
-                   lRect.Sze.H, tableStyle.ColSepChar() );
-          // skip over
-          destWidth = tableStyle.ColSepWidth();
+      wrect cRect( at );
+      cRect.Pos.C = x;
+      cRect.Sze.W = std::min( destWidth, right - x );
 
-          if ( (unsigned) lRect.Sze.W <= destWidth )
-            break;
+      x += destWidth + sepWidth;
 
-          lRect.Pos.C += destWidth;
-          lRect.Sze.W -= destWidth;
-        }
-      }
-
-      destWidth = tableStyle.ColWidth( col );
+      const unsigned state = ( _activeColumn == col && active ) ? S_NORMAL : _vstate;
 
-      wrect cRect( lRect );
+      // nothing to do if the cell and its separator are already shown
+      if ( _cells[ col ] && _renderedFrame
+           && cellUnchanged( col, cRect, state, tableStyle ) )
+        continue;
 
-      // Adjust drawing rectangle for the screen space we just used
-      lRect.Pos.C += destWidth;
-      lRect.Sze.W -= destWidth;
+      if ( col > 0 && sepWidth )
+      {
+        // draw centered in the gap before the column
+        int sepCol = cRect.Pos.C - sepWidth + sepWidth / 2;
 
-      if ( lRect.Sze.W < 0 )
-        cRect.Sze.W = destWidth + lRect.Sze.W;
-      else
-        cRect.Sze.W = destWidth;
+        if ( sepCol >= at.Pos.C )
+        {
+          w.bkgdset( separatorBG );
+          w.vline( at.Pos.L, sepCol, at.Sze.H, tableStyle.ColSepChar() );
+        }
+      }
 
       if ( _cells[ col ] )
       {
         // Draw item
-        if (_activeColumn == col && active)
-        {
-          _cells[ col ]->DrawAt( w, cRect, tableStyle, S_NORMAL, col );
-        }
-        else
-        {
-          _cells[ col ]->DrawAt( w, cRect, tableStyle, _vstate, col );
-        }
+        _cells[ col ]->DrawAt( w, cRect, tableStyle, (NCTableLine::STATE) state, col );
 
         // Draw tree hierarchy line graphics over the prefix placeholder
 
@@ -190,11 +299,328 @@ protected:
     }
   }
 
+  // reimplemented to paint only the cells that changed since the line
+  // was last painted into the pad
+  virtual void DrawAt( NCursesWindow & w,
+                       const wrect     at,
+                       NCTableStyle &  tableStyle,
+                       bool            active ) const override
+  {
+    const NCColSelTablePad * pad = dynamic_cast<const NCColSelTablePad *>( &w );
+
+    if ( pad
+         && pad->frame()  == _renderedFrame
+         && at.Pos.L      == _renderedRow
+         && _state        == _renderedState
+         && active        == _renderedActive )
+    {
+      // line background and separators are still in place
+      DrawItems( w, at, tableStyle, active );
+      return;
+    }
+
+    _rendered.clear();
+    _renderedFrame  = pad ? pad->frame() : 0;
+    _renderedRow    = at.Pos.L;
+    _renderedState  = _state;
+    _renderedActive = active;
+
+    NCTableLine::DrawAt( w, at, tableStyle, active );
+  }
+
+protected:
+  // reimplemented to get a single selected column
+  virtual void DrawItems( NCursesWindow & w,
+                          const wrect     at,
+                          NCTableStyle &  tableStyle,
+                          bool            active ) const override
+  {
+    if ( !( at.Sze > wsze( 0 ) ) || !Cols() )
+      return;
+
+    // only the columns around the visible part of a table pad
+    const NCColSelTablePad * pad = dynamic_cast<const NCColSelTablePad *>( &w );
+
+    if ( pad && pad->hasColumns() )
+      drawColumns( w, at, tableStyle, active,
+                   pad->firstColumn(), pad->lastColumn(),
+                   at.Pos.C + pad->columnStart( pad->firstColumn() ) );
+    else
+      drawColumns( w, at, tableStyle, active, 0, Cols() - 1, at.Pos.C );
+  }
+
+  NCMGACellStyles * _cellStyles;   // owned by the table
   unsigned int _activeColumn;
 
+private:
+
+  /**
+   * What a cell was last painted from.
+   **/
+  struct RenderedCell
+  {
+    RenderedCell()
+      : cell( 0 ), selected( false ), state( 0 ), x( 0 ), width( 0 )
+      , list( 0 ), bg( 0 ), adjust( NC::LEFT )
+      {}
+
+    const NCTableCol *      cell;
+    std::wstring            text;      // label lines, '\n' separated
+    bool                    selected;  // tag cells
+    unsigned                state;     // line state the cell was drawn with
+    int                     x;
+    int                     width;
+    const NCstyle::StList * list;      // list style the cell was drawn with
+    chtype                  bg;        // column background (hot or data)
+    NC::ADJUST              adjust;    // column alignment
+  };
+
+  /**
+   * Return 'true' if cell 'col' is still shown in 'rect' as it would be
+   * painted now with line state 'state' and the attributes and alignment
+   * of 'tableStyle'. Otherwise the cell is recorded as painted that way
+   * and 'false' is returned.
+   **/
+  bool cellUnchanged( unsigned             col,
+                      const wrect &        rect,
+                      unsigned             state,
+                      const NCTableStyle & tableStyle ) const
+  {
+    if ( _rendered.size() < Cols() )
+      _rendered.resize( Cols() );
+
+    RenderedCell &     rendered( _rendered[ col ] );
+    const NCTableCol * cell = _cells[ col ];
+    const NCTableTag * tag  = dynamic_cast<const NCTableTag *>( cell );
+    const bool         selected = tag && tag->Selected();
+
+    const NCstyle::StList * list   = &tableStyle.listStyle();
+    const chtype            bg     = _cellStyles->hotBG( state, col );
+    const NC::ADJUST        adjust = tableStyle.ColAdjust( col );
+
+    if ( rendered.cell     == cell
+         && rendered.state == state
+         && rendered.x     == rect.Pos.C
+         && rendered.width == rect.Sze.W
+         && rendered.selected == selected
+         && rendered.list   == list
+         && rendered.bg     == bg
+         && rendered.adjust == adjust
+         && sameText( rendered.text, cell->Label() ) )
+      return true;
+
+    rendered.cell     = cell;
+    rendered.state    = state;
+    rendered.x        = rect.Pos.C;
+    rendered.width    = rect.Sze.W;
+    rendered.selected = selected;
+    rendered.list     = list;
+    rendered.bg       = bg;
+    rendered.adjust   = adjust;
+    rendered.text.clear();
+
+    for ( const NCstring & line : cell->Label().Text() )
+    {
+      if ( !rendered.text.empty() )
+        rendered.text += L'\n';
+      rendered.text += line.str();
+    }
+
+    return false;
+  }
+
+  /**
+   * Return 'true' if 'text' holds the lines of 'label'.
+   **/
+  static bool sameText( const std::wstring & text, const NClabel & label )
+  {
+    size_t pos = 0;
+
+    for ( const NCstring & line : label.Text() )
+    {
+      if ( pos )
+      {
+        if ( pos >= text.size() || text[ pos ] != L'\n' )
+          return false;
+        ++pos;
+      }
+
+      const std::wstring & str( line.str() );
+
+      if ( text.compare( pos, str.size(), str ) != 0 )
+        return false;
+
+      pos += str.size();
+    }
+
+    return pos == text.size();
+  }
+
+  // cells as last painted into the pad, valid while the line is still
+  // shown in frame '_renderedFrame' at row '_renderedRow' in the same
+  // state
+  mutable std::vector<RenderedCell> _rendered;
+  mutable unsigned                  _renderedFrame;
+  mutable int                       _renderedRow;
+  mutable unsigned                  _renderedState;
+  mutable bool                      _renderedActive;
+
 };
 
 
+void NCColSelTablePad::prepareRedraw()
+{
+  // updates the format and clears the pad
+  NCTablePad::prepareRedraw();
+  ++_frame;
+  _shown = wpos( -1, -1 );
+
+  const unsigned cols     = _itemStyle.Cols();
+  const int      sepWidth = _itemStyle.ColSepWidth();
+
+  _starts.resize( cols + 1 );
+
+  int x = 0;
+  for ( unsigned col = 0; col < cols; ++col )
+  {
+    _starts[ col ] = x;
+    x += _itemStyle.ColWidth( col ) + sepWidth;
+  }
+  _starts[ cols ] = x;
+
+  if ( !cols )
+  {
+    _first = 1;
+    _last  = 0;
+    return;
+  }
+
+  const int view = std::max( (int) srect.Sze.W, 1 );
+
+  _first = columnAt( srect.Pos.C - view );
+  _last  = columnAt( srect.Pos.C + 2 * view - 1 );
+}
+
+
+unsigned NCColSelTablePad::columnAt( int x ) const
+{
+  if ( _starts.size() < 2 || x <= 0 )
+    return 0;
+
+  std::vector<int>::const_iterator it =
+    std::upper_bound( _starts.begin(), _starts.end() - 1, x );
+
+  return ( it - _starts.begin() ) - 1;
+}
+
+
+void NCColSelTablePad::paintColumns( unsigned first, unsigned last )
+{
+  for ( unsigned l = 0; l < _visibleItems.size(); ++l )
+  {
+    const NCColSelTableLine * line = dynamic_cast<const NCColSelTableLine *>( _visibleItems[ l ] );
+
+    if ( line )
+      line->drawColumns( *this, wrect( wpos( l, 0 ), wsze( 1, width() ) ),
+                         _itemStyle, (int) l == _citem.L,
+                         first, last, _starts[ first ] );
+  }
+}
+
+
+void NCColSelTablePad::redrawLine( unsigned lineNo )
+{
+  if ( dirty )
+  {
+    DoRedraw();
+    return;
+  }
+
+  if ( lineNo >= _visibleItems.size() )
+    return;
+
+  _visibleItems[ lineNo ]->DrawAt( *this, wrect( wpos( lineNo, 0 ), wsze( 1, width() ) ),
+                                   _itemStyle, (int) lineNo == _citem.L );
+  update();
+}
+
+
+int NCColSelTablePad::lineAfter( wint_t key, unsigned count ) const
+{
+  const int page = std::max( (int) drect.Sze.H - 1, 1 );
+  const int last = (int) _visibleItems.size() - 1;
+  int       line = _citem.L;
+
+  switch ( key )
+  {
+    case KEY_UP:    line -= (int) count;        break;
+    case KEY_DOWN:  line += (int) count;        break;
+    case KEY_PPAGE: line -= (int) count * page; break;
+    case KEY_NPAGE: line += (int) count * page; break;
+  }
+
+  return std::max( 0, std::min( line, last ) );
+}
+
+
+void NCColSelTablePad::Destwin( NCursesWindow * dwin )
+{
+  NCTablePad::Destwin( dwin );
+  _shown = wpos( -1, -1 );
+
+  if ( dwin )
+    dwin->idlok( true );
+}
+
+
+int NCColSelTablePad::update()
+{
+  const int delta = srect.Pos.L - _shown.L;
+
+  if ( destwin && !dirty && _shown.L >= 0 && srect.Pos.C == _shown.C
+       && delta != 0 && std::abs( delta ) < (int) drect.Sze.H )
+  {
+    // the cursor has to be in the scrolling region to set it
+    destwin->move( drect.Pos.L, 0 );
+    destwin->setscrreg( drect.Pos.L, drect.Pos.L + drect.Sze.H - 1 );
+    destwin->scrollok( true );
+    destwin->scrl( delta );
+    destwin->scrollok( false );
+    destwin->setscrreg( 0, destwin->height() - 1 );
+  }
+
+  int ret = NCTablePad::update();
+  _shown = dirty ? wpos( -1, -1 ) : srect.Pos;
+
+  return ret;
+}
+
+
+int NCColSelTablePad::setpos( const wpos & newpos )
+{
+  // a pending full redraw paints the new position anyway
+  if ( !dirty && hasColumns() && newpos.C != srect.Pos.C )
+  {
+    const unsigned first = columnAt( newpos.C );
+    const unsigned last  = columnAt( newpos.C + srect.Sze.W - 1 );
+
+    if ( first < _first )
+    {
+      paintColumns( first, _first - 1 );
+      _first = first;
+    }
+
+    if ( last > _last )
+    {
+      paintColumns( _last + 1, last );
+      _last = last;
+    }
+  }
+
+  return NCTablePad::setpos( newpos );
+}
+
+
 /*
  * Some remarks about single/multi selection:
  *
@@ -225,6 +651,12 @@ YMGA_NCCBTable::YMGA_NCCBTable( YWidget * parent,
     , _sortReverse( false )
     , _sortStrategy( new NCTableSortDefault() )
     , _currentColumn ( 0 )
+    , _stats( new NCMGAStats( "YMGA_NCCBTable" ) )
+    , _asyncPopups( false )
+    , _sortMenu( 0 )
+    , _eventLevel( 0 )
+    , _drawPending( false )
+    , _eventPaints( 0 )
 {
     // yuiDebug() << endl;
 
@@ -237,6 +669,13 @@ YMGA_NCCBTable::~YMGA_NCCBTable()
 {
     if ( _sortStrategy )
         delete _sortStrategy;
+
+    delete _sortMenu;
+
+    for ( YItem * item : _sortMenuItems )
+        delete item;
+
+    delete _stats;
 }
 
 
@@ -370,6 +809,8 @@ vector<string> YMGA_NCCBTable::getHeader() const
 
 void YMGA_NCCBTable::addItems( const YItemCollection & itemCollection )
 {
+  NCMGATraceSpan span( "YMGA_NCCBTable::addItems" );
+
   myPad()->ClearTable();
   YMGA_CBTable::addItems( itemCollection );
 
@@ -454,7 +895,11 @@ void YMGA_NCCBTable::addPadLine( NCTableLine *      parentLine,
       tableColumn = new NCTableCol( NCstring(( *it )->label() ) );
 
     cells.push_back( tableColumn );
+    _stats->add( NCMGAStats::LabelBytes, ( *it )->label().size() );
   }
+  _stats->add( NCMGAStats::TableCellsAllocated, cells.size() );
+  _stats->add( NCMGAStats::TableLinesBuilt );
+
   int index = myPad()->Lines();
   item->setIndex( index );
 
@@ -468,6 +913,7 @@ void YMGA_NCCBTable::addPadLine( NCTableLine *      parentLine,
   NCColSelTableLine *line = new NCColSelTableLine( pLine,
                                        item,
                                        cells,
+                                       &_cellStyles,
                                        index,
                                        _nestedItems,
                                        state );
@@ -491,6 +937,8 @@ void YMGA_NCCBTable::addPadLine( NCTableLine *      parentLine,
 
 void YMGA_NCCBTable::rebuildPadLines()
 {
+  NCMGATraceSpan span( "YMGA_NCCBTable::rebuildPadLines" );
+
   myPad()->ClearTable();
   _nestedItems = hasNestedItems( itemsBegin(), itemsEnd() );
 
@@ -654,6 +1102,43 @@ void YMGA_NCCBTable::selectCurrentItem()
 }
 
 
+void YMGA_NCCBTable::DrawCurrentLine()
+{
+  NCColSelTablePad * pad = dynamic_cast<NCColSelTablePad *>( myPad() );
+
+  // a pending redraw covers the line as well
+  if ( _drawPending )
+    return;
+
+  if ( pad && !myPad()->empty() )
+  {
+    pad->redrawLine( myPad()->CurPos().L );
+    ++_eventPaints;
+    _stats->add( NCMGAStats::TableLinePaints );
+  }
+  else
+    DrawPad();
+}
+
+
+void YMGA_NCCBTable::DrawPad()
+{
+  if ( _eventLevel > 0 )
+  {
+    _drawPending = true;
+    return;
+  }
+
+  NCMGATraceSpan span( "YMGA_NCCBTable::DrawPad" );
+
+  _drawPending = false;
+  ++_eventPaints;
+  _stats->add( NCMGAStats::TablePaints );
+
+  NCPadWidget::DrawPad();
+}
+
+
 void YMGA_NCCBTable::deselectAllItems()
 {
   if ( !hasMultiSelection() ) // keep compatibility to help in integration/merge)
@@ -725,7 +1210,7 @@ bool YMGA_NCCBTable::setItemByKey( int key )
 NCPad * YMGA_NCCBTable::CreatePad()
 {
   wsze    psze( defPadSze() );
-  NCPad * npad = new NCTablePad( psze.H, psze.W, *this );
+  NCPad * npad = new NCColSelTablePad( psze.H, psze.W, *this );
   npad->bkgd( listStyle().item.plain );
 
   return npad;
@@ -739,11 +1224,53 @@ NCPad * YMGA_NCCBTable::CreatePad()
  * are propagated to the pad and to the items.
  **/
 NCursesEvent YMGA_NCCBTable::wHandleInput( wint_t key )
+{
+  NCMGATraceSpan span( "YMGA_NCCBTable::wHandleInput" );
+  NCMGAStats::poll();
+
+  // all the redraws requested while handling the key are done once at
+  // the end
+  ++_eventLevel;
+  _eventPaints = 0;
+
+  NCursesEvent ret;
+
+  try
+  {
+    ret = handleKey( key );
+  }
+  catch ( ... )
+  {
+    --_eventLevel;
+    throw;
+  }
+
+  if ( --_eventLevel == 0 && _drawPending )
+    DrawPad();
+
+  mgaDebug() << "Paints for key " << key << ": " << _eventPaints << std::endl;
+
+  return ret;
+}
+
+
+NCursesEvent YMGA_NCCBTable::handleKey( wint_t key )
 {
   NCursesEvent ret  = NCursesEvent::none;
   bool sendEvent    = false;
   int  currentIndex = getCurrentItem();
 
+  if ( _sortMenu && _sortMenu->isOpen() )
+  {
+    // asynchronous sort popup
+    NCursesEvent ev = _sortMenu->handleInput( key );
+
+    if ( ev == NCursesEvent::menu )
+      sortByUser( ev.selection->index() );
+
+    return NCursesEvent::none;
+  }
+
   // Call the pad's input handler via NCPadWidget::handleInput()
   // which calls its pad class's input handler
   // which may call the current item's input handler.
@@ -755,7 +1282,23 @@ NCursesEvent YMGA_NCCBTable::wHandleInput( wint_t key )
   // - NCTablePadBase::handleInput()
   // - NCTableLine::handleInput()
 
-  bool handled = handleInput( key ); // NCTablePad::handleInput()
+  NCColSelTablePad * pad = dynamic_cast<NCColSelTablePad *>( myPad() );
+  unsigned repeats = 0;
+  bool     handled;
+
+  if ( pad && !pad->empty() && NCMGAInput::isNavigationKey( key ) )
+    repeats = NCMGAInput::drain( key );
+
+  if ( repeats )
+  {
+    // Keys repeated meanwhile (key repeat, paste) are summed up and the
+    // cursor is moved once, so the pad repaints, the selection and the
+    // event below are done once for the whole burst.
+    pad->ScrlLine( pad->lineAfter( key, 1 + repeats ) );
+    handled = true;
+  }
+  else
+    handled = handleInput( key ); // NCTablePad::handleInput()
 
   switch ( key )
   {
@@ -782,7 +1325,7 @@ NCursesEvent YMGA_NCCBTable::wHandleInput( wint_t key )
           {
             NCColSelTableLine * line = dynamic_cast<NCColSelTableLine *>(currentLine);
             line->setActiveColumn(col);
-            DrawPad();
+            DrawCurrentLine();
           }
         }
       }
@@ -800,7 +1343,7 @@ NCursesEvent YMGA_NCCBTable::wHandleInput( wint_t key )
           {
             NCColSelTableLine * line = dynamic_cast<NCColSelTableLine *>(currentLine);
             line->setActiveColumn(col);
-            DrawPad();
+            DrawCurrentLine();
           }
         }
       }
@@ -829,6 +1372,7 @@ NCursesEvent YMGA_NCCBTable::wHandleInput( wint_t key )
           if (pItem)
           {
             setItemChecked( pItem, _currentColumn, !pItem->checked(_currentColumn) );
+            DrawCurrentLine();
             pItem->setChangedColumn(_currentColumn);
             YMGA_CBTable::setChangedItem(pItem);
             return NCursesEvent::ValueChanged;
@@ -847,6 +1391,14 @@ NCursesEvent YMGA_NCCBTable::wHandleInput( wint_t key )
       break;
   }
 
+  // keys the table does not use may be accelerators of the menu bar
+  if ( !handled && !sendEvent && currentIndex == getCurrentItem() )
+  {
+    ret = YMGANCMenuBar::dialogAccelerator( this, key );
+    if ( ret != NCursesEvent::none )
+      return ret;
+  }
+
   if (  currentIndex != getCurrentItem() )
   {
     if ( notify() && immediateMode() )
@@ -854,8 +1406,10 @@ NCursesEvent YMGA_NCCBTable::wHandleInput( wint_t key )
 
     if ( !hasMultiSelection() )
     {
+      // The pad has already repainted the old and the new current line
+      // and scrolled; only the active column of the new one is left.
       selectCurrentItem();
-      DrawPad();
+      DrawCurrentLine();
     }
   }
 
@@ -905,38 +1459,79 @@ void YMGA_NCCBTable::interactiveSort()
     // Get the column; show the popup in the table's upper left corner
     wpos pos( ScreenPos() + wpos( 2, 1 ) );
 
+    if ( _asyncPopups )
+    {
+      // The choice arrives later through wHandleInput()
+      if ( !_sortMenu )
+      {
+        _sortMenu = new NCMGAMenuCascade();
+        YUI_CHECK_NEW( _sortMenu );
+        _sortMenu->setStats( _stats );
+        _stats->add( NCMGAStats::PopupMenus );
+      }
+
+      _sortMenu->invalidate();
+
+      for ( YItem * item : _sortMenuItems )
+        delete item;
+      _sortMenuItems = menuItems;
+
+      _sortMenu->setStyle( widgetStyle( true ), widgetStyle( false ), wStyle().disabled );
+      _sortMenu->open( 0, _sortMenuItems.begin(), _sortMenuItems.end(), pos );
+
+      return;
+    }
+
     NCPopupMenu *dialog = new NCPopupMenu( pos, menuItems.begin(), menuItems.end() );
     int sortCol = dialog->post();
 
     // close the popup
     YDialog::deleteTopmostDialog();
 
-    if ( sortCol != -1 && hasColumn( sortCol ) )
-    {
-      //
-      // Do the sorting
-      //
+    sortByUser( sortCol );
+  }
+}
 
-      yuiDebug() << "Manually sorting by column #"
-      << sortCol << ": " << header( sortCol )
-      << endl;
 
-      _sortReverse = sortCol == _lastSortCol ?
-      ! _sortReverse : false;
+void YMGA_NCCBTable::SetState( const NC::WState newstate, const bool force )
+{
+  // the focus moved to another widget
+  if ( newstate != NC::WSactive && _sortMenu && _sortMenu->isOpen() )
+    _sortMenu->close();
 
-      sortItems( sortCol, _sortReverse );
+  NCPadWidget::SetState( newstate, force );
+}
 
-      if ( !hasMultiSelection() )
-        selectCurrentItem();
 
-      DrawPad();
-    }
+void YMGA_NCCBTable::sortByUser( int sortCol )
+{
+  if ( sortCol != -1 && hasColumn( sortCol ) )
+  {
+    //
+    // Do the sorting
+    //
+
+    yuiDebug() << "Manually sorting by column #"
+    << sortCol << ": " << header( sortCol )
+    << endl;
+
+    _sortReverse = sortCol == _lastSortCol ?
+    ! _sortReverse : false;
+
+    sortItems( sortCol, _sortReverse );
+
+    if ( !hasMultiSelection() )
+      selectCurrentItem();
+
+    DrawPad();
   }
 }
 
 
 void YMGA_NCCBTable::sortItems( int sortCol, bool reverse )
 {
+  NCMGATraceSpan span( "YMGA_NCCBTable::sortItems" );
+
   // NOTE that if column is reserved to checkboxes sorting does not make sense
   if ( !isCheckBoxColumn(sortCol) )
   {
@@ -962,8 +1557,20 @@ void YMGA_NCCBTable::sortItems( int sortCol, bool reverse )
     _sortStrategy->setReverse( reverse );
     _lastSortCol = sortCol;
 
+    std::chrono::steady_clock::time_point start;
+    if ( NCMGAStats::enabled() )
+      start = std::chrono::steady_clock::now();
+
     sortYItems( itemsBegin(), itemsEnd() );
 
+    if ( NCMGAStats::enabled() )
+    {
+      _stats->add( NCMGAStats::TableSorts );
+      _stats->add( NCMGAStats::TableSortMicroseconds,
+                  std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start ).count() );
+    }
+
     rebuildPadLines();
   }
 }
@@ -972,6 +1579,8 @@ void YMGA_NCCBTable::sortItems( int sortCol, bool reverse )
 void YMGA_NCCBTable::sortYItems( YItemIterator begin,
                                  YItemIterator end )
 {
+  NCMGATraceSpan span( "YMGA_NCCBTable::sortYItems" );
+
   // Sort the children first as long as the iterators are
   // guaranteed to be valid
 
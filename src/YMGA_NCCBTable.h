@@ -31,6 +31,11 @@
 #include <yui/ncurses/NCTablePad.h>
 #include <yui/ncurses/NCTableSort.h>
 
+#include "NCMGACellStyles.h"
+
+class NCMGAMenuCascade;
+class NCMGAStats;
+
 class YMGA_NCCBTable : public YMGA_CBTable, public NCPadWidget
 {
     friend std::ostream & operator<<( std::ostream & str, const YMGA_NCCBTable & obj );
@@ -257,6 +262,28 @@ public:
      **/
     NCTableSortStrategyBase * sortStrategy() const { return _sortStrategy; }
 
+    /**
+     * Enable or disable an asynchronous sort popup.
+     *
+     * By default the column menu is a popup dialog with its own
+     * (blocking) event loop. If enabled, interactiveSort() opens the
+     * column menu and returns immediately; the menu is then driven by
+     * wHandleInput() through the normal dialog event loop, so the table
+     * keeps updating meanwhile. The menu is closed when the table loses
+     * the focus.
+     **/
+    void setAsyncPopups( bool async = true ) { _asyncPopups = async; }
+
+    /**
+     * Return 'true' if the sort popup is asynchronous.
+     **/
+    bool asyncPopups() const { return _asyncPopups; }
+
+    /**
+     * Performance counters of this table, its sort popup included.
+     **/
+    const NCMGAStats & stats() const { return *_stats; }
+
     /**
      * check/uncheck Item from application.
      *
@@ -273,6 +300,12 @@ public:
      **/
     virtual int getCurrentColumn() const;
 
+    /**
+     * Number of paints (of the whole pad or of the current line) done for
+     * the last input event.
+     **/
+    unsigned lastEventPaints() const { return _eventPaints; }
+
 protected:
 
     /**
@@ -345,6 +378,30 @@ protected:
      **/
     void rebuildHeaderLine();
 
+    /**
+     * Repaint the current line only, e.g. after its active column has
+     * changed. This falls back to DrawPad() if the pad needs a full
+     * redraw anyway.
+     **/
+    void DrawCurrentLine();
+
+    /**
+     * Reimplemented to merge the redraws requested while an input event
+     * is handled into a single one at the end of the event.
+     **/
+    virtual void DrawPad();
+
+    /**
+     * Reimplemented from NCWidget to close the sort popup when the focus
+     * moves to another widget.
+     **/
+    virtual void SetState( const NC::WState newstate, const bool force = false ) override;
+
+    /**
+     * Handle 'key' for wHandleInput() (which defers the redraws).
+     **/
+    NCursesEvent handleKey( wint_t key );
+
     /**
      * Return the NCurses alignment string for the alignment of the
      * specified column: One of "L", "C", "R" (Left, Center, Right).
@@ -423,6 +480,12 @@ protected:
      **/
     void interactiveSort();
 
+    /**
+     * Sort by column no. 'sortCol' as chosen by the user: a second request
+     * for the same column reverses the sort order.
+     **/
+    void sortByUser( int sortCol );
+
     /**
      * Sort the items by column no. 'sortCol' with the current sort strategy.
      *
@@ -475,6 +538,21 @@ private:
 
     unsigned int _currentColumn;
 
+    // cell backgrounds of the lines
+    NCMGACellStyles _cellStyles;
+
+    // performance counters, see NCMGAStats
+    NCMGAStats * _stats;                        //< owned
+
+    bool _asyncPopups;
+    NCMGAMenuCascade * _sortMenu;               //< owned
+    YItemCollection    _sortMenuItems;          //< owned
+
+    // redraws are deferred while an input event is handled
+    int      _eventLevel;
+    bool     _drawPending;
+    unsigned _eventPaints;
+
 
 
 